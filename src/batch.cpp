@@ -0,0 +1,266 @@
+#include "include/common.hpp"
+#include "include/caches.hpp"
+#include "include/solver.hpp"
+#include "include/checker.hpp"
+
+#include <condition_variable>
+#include <filesystem>
+#include <sstream>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+// Runs many instances inside one process. Each instance gets a share of the
+// cores proportional to its size, so small instances don't hold the whole
+// machine while large ones wait.
+//
+// Usage: batch <datasets dir | manifest> [-o results_dir] [-r best_objectives.csv]
+//              [--csv out.csv] [--json out.json] [-H heuristic] [-t threads] [-p patience_s] [-P params] [-s seed]
+
+struct Instance {
+    std::string path, dataset, name;
+    uintmax_t bytes;
+};
+
+struct BatchResult {
+    std::string dataset, name;
+    double objective = 0.0, bestKnown = NAN, seconds = 0.0;
+    bool feasible = false;
+    size_t orders = 0, aisles = 0, threads = 0;
+    size_t coldRuns = 0, skippedRuns = 0; // Duplicate-cache lookups and hits
+    ll units = 0;
+};
+
+// Counts free cores; an instance blocks until it can take all the threads it was given
+struct CorePool {
+    size_t freeCores;
+    mutex m;
+    condition_variable cv;
+
+    CorePool(size_t n) : freeCores(n) {}
+
+    void acquire(size_t k) {
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [&] { return freeCores >= k; });
+        freeCores -= k;
+    }
+
+    void release(size_t k) {
+        { lock_guard<mutex> lock(m); freeCores += k; }
+        cv.notify_all();
+    }
+};
+
+static Instance makeInstance(const fs::path &path) {
+    return { path.string(), path.parent_path().filename().string(), path.filename().string(), fs::file_size(path) };
+}
+
+static vector<Instance> collectInstances(const std::string &source) {
+    vector<Instance> instances;
+    if (fs::is_directory(source)) {
+        for (const auto &entry : fs::recursive_directory_iterator(source))
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+                instances.pb(makeInstance(entry.path()));
+    } else {
+        // Manifest: one instance path per line, relative to the manifest itself
+        std::ifstream manifest(source);
+        fs::path base = fs::path(source).parent_path();
+        std::string line;
+        while (std::getline(manifest, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            fs::path path(line);
+            if (path.is_relative()) path = base / path;
+            if (fs::is_regular_file(path)) instances.pb(makeInstance(path));
+            else std::cerr << "Skipping missing instance " << path << std::endl;
+        }
+    }
+    return instances;
+}
+
+static map<pair<std::string, std::string>, double> readReference(const std::string &path) {
+    map<pair<std::string, std::string>, double> reference;
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string dataset, name, value;
+        if (std::getline(ss, dataset, ',') && std::getline(ss, name, ',') && std::getline(ss, value))
+            reference[{dataset, name}] = std::stod(value);
+    }
+    return reference;
+}
+
+// Threads per instance: one per 128 KiB of input, capped by the machine
+static size_t threadsFor(const Instance &instance, size_t budget) {
+    size_t threads = instance.bytes / (128 * 1024);
+    return std::max<size_t>(1, std::min(threads, budget));
+}
+
+static double gapOf(const BatchResult &r) {
+    if (std::isnan(r.bestKnown) || r.bestKnown <= 0) return NAN;
+    return (r.bestKnown - r.objective) / r.bestKnown * 100.0;
+}
+
+static void writeCsv(const std::string &path, const vector<BatchResult> &results) {
+    std::ofstream out(path);
+    out << "dataset,instance,objective,feasible,orders,aisles,units,threads,seconds,best_objective,gap,"
+        << "cold_runs,skipped_runs\n";
+    for (const auto &r : results) {
+        out << r.dataset << ',' << r.name << ',' << std::setprecision(17) << r.objective << ','
+            << (r.feasible ? 1 : 0) << ',' << r.orders << ',' << r.aisles << ',' << r.units << ','
+            << r.threads << ',' << std::setprecision(6) << r.seconds << ',';
+        if (!std::isnan(r.bestKnown)) out << std::setprecision(17) << r.bestKnown;
+        out << ',';
+        if (!std::isnan(gapOf(r))) out << std::setprecision(6) << gapOf(r);
+        out << ',' << r.coldRuns << ',' << r.skippedRuns << '\n';
+    }
+}
+
+static void writeJson(const std::string &path, const vector<BatchResult> &results) {
+    std::ofstream out(path);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i += 1) {
+        const auto &r = results[i];
+        out << "  {\"dataset\": \"" << r.dataset << "\", \"instance\": \"" << r.name << "\", "
+            << "\"objective\": " << std::setprecision(17) << r.objective << ", "
+            << "\"feasible\": " << (r.feasible ? "true" : "false") << ", "
+            << "\"orders\": " << r.orders << ", \"aisles\": " << r.aisles << ", \"units\": " << r.units << ", "
+            << "\"threads\": " << r.threads << ", \"seconds\": " << std::setprecision(6) << r.seconds << ", "
+            << "\"best_objective\": ";
+        if (std::isnan(r.bestKnown)) out << "null"; else out << std::setprecision(17) << r.bestKnown;
+        out << ", \"gap\": ";
+        if (std::isnan(gapOf(r))) out << "null"; else out << std::setprecision(6) << gapOf(r);
+        out << ", \"cold_runs\": " << r.coldRuns << ", \"skipped_runs\": " << r.skippedRuns;
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <datasets dir | manifest> [-o results_dir] [-r best_objectives.csv]"
+                  << " [--csv out.csv] [--json out.json] [-H heuristic] [-t threads] [-p patience_s] [-P params] [-s seed]" << std::endl;
+        return 1;
+    }
+
+    std::string source = argv[1], outputDir = "results", referencePath, csvPath = "batch.csv", jsonPath, paramsPath;
+    double patience = -1; // -1 = the preset's
+    Solver::Config base;
+    base.verbose = false;
+    size_t budget = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; i += 2) {
+        std::string flag = argv[i];
+        if (i + 1 >= argc) { std::cerr << "Missing value for " << flag << std::endl; return 1; }
+        std::string value = argv[i + 1];
+        if (flag == "-o") outputDir = value;
+        else if (flag == "-r") referencePath = value;
+        else if (flag == "--csv") csvPath = value;
+        else if (flag == "--json") jsonPath = value;
+        else if (flag == "-H") base.heuristic = std::stoi(value);
+        else if (flag == "-t") budget = std::max(1, std::stoi(value));
+        else if (flag == "-s") Seed::base = std::stoul(value);
+        else if (flag == "-p") patience = std::stod(value);
+        else if (flag == "-P") paramsPath = value;
+        else { std::cerr << "Unknown option " << flag << std::endl; return 1; }
+    }
+
+    Params checked;
+    if (!paramsPath.empty() && !Params::load(paramsPath, checked)) return 1;
+
+    vector<Instance> instances = collectInstances(source);
+    if (instances.empty()) {
+        std::cerr << "No instances found in " << source << std::endl;
+        return 1;
+    }
+
+    // Largest first: they take the most threads, small ones fill the gaps
+    std::sort(all(instances), [](const Instance &a, const Instance &b) { return a.bytes > b.bytes; });
+
+    map<pair<std::string, std::string>, double> reference;
+    if (!referencePath.empty()) reference = readReference(referencePath);
+
+    std::cerr << "Running " << instances.size() << " instances on " << budget << " threads" << std::endl;
+    auto batchStart = chrono::high_resolution_clock::now();
+
+    vector<BatchResult> results(instances.size());
+    vector<std::thread> running;
+    CorePool pool(budget);
+    mutex logMutex;
+
+    for (size_t i = 0; i < instances.size(); i += 1) {
+        size_t threads = threadsFor(instances[i], budget);
+        pool.acquire(threads);
+
+        running.emplace_back([&, i, threads] {
+            const Instance &instance = instances[i];
+            BatchResult &r = results[i];
+            auto start = chrono::high_resolution_clock::now();
+
+            r.dataset = instance.dataset;
+            r.name = instance.name;
+            auto ref = reference.find({r.dataset, r.name});
+            if (ref != reference.end()) r.bestKnown = ref->ss;
+
+            // An unreadable instance is reported infeasible, with no solution file
+            Problem p;
+            if (!Problem::ReadFromFile(instance.path, p)) {
+                {
+                    lock_guard<mutex> lock(logMutex);
+                    std::cerr << r.dataset << '/' << r.name << ": cannot read " << instance.path << std::endl;
+                }
+                r.feasible = false;
+                r.threads = threads;
+                pool.release(threads);
+                return;
+            }
+
+            // The keys of a parameter file override the size preset; -p beats both
+            Solver::Config config = base;
+            config.threadCount = threads;
+            config.params = Params::preset(p.orders.size(), config.heuristic);
+            if (!paramsPath.empty()) Params::load(paramsPath, config.params);
+            if (patience >= 0) config.params.patience = patience;
+            Solver::Stats stats;
+            config.stats = &stats;
+            Solution best = Solver::solve(p, config);
+
+            fs::path outPath = fs::path(outputDir) / instance.dataset / instance.name;
+            fs::create_directories(outPath.parent_path());
+            std::ofstream out(outPath);
+            best.print(out);
+
+            auto report = Checker::check(p, best);
+            r.feasible = report.feasible;
+            r.objective = r.feasible ? report.objective : 0.0;
+            r.orders = report.orders;
+            r.aisles = report.aisles;
+            r.units = report.units;
+            r.threads = threads;
+            r.coldRuns = stats.coldRuns;
+            r.skippedRuns = stats.skippedRuns;
+            r.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+            {
+                lock_guard<mutex> lock(logMutex);
+                std::cerr << r.dataset << '/' << r.name << ": " << r.objective
+                          << (r.feasible ? "" : " (INFEASIBLE)") << " in " << r.seconds << "s on "
+                          << threads << " threads" << std::endl;
+            }
+            pool.release(threads);
+        });
+    }
+    for (auto &t : running) t.join();
+
+    std::sort(all(results), [](const BatchResult &a, const BatchResult &b) {
+        return make_pair(a.dataset, a.name) < make_pair(b.dataset, b.name);
+    });
+
+    if (!csvPath.empty()) writeCsv(csvPath, results);
+    if (!jsonPath.empty()) writeJson(jsonPath, results);
+
+    chrono::duration<double> total = chrono::high_resolution_clock::now() - batchStart;
+    std::cerr << "Batch finished in " << total.count() << "s" << std::endl;
+    return 0;
+}
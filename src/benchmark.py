@@ -0,0 +1,279 @@
+import os
+import re
+import sys
+import csv
+import json
+import time
+import argparse
+import statistics
+import subprocess
+
+# Benchmark de tempo-até-alvo: roda cada modo (heurística + flags) sobre as
+# instâncias escolhidas, com sementes fixas e várias repetições, e mede pelo
+# trace quanto tempo leva para chegar a 95%, 99% e 100% do best_objective de
+# best_solutions/best_objectives.csv, além do gap final. O relatório sai em
+# JSON; com --baseline ele é comparado a um relatório guardado e regressões
+# fazem o script sair com código 1. Se o baseline ainda não existe, o
+# relatório desta rodada é gravado nele e não há comparação.
+#
+# Cada resultado traz também o tempo mediano de uma passada de refinamento
+# (construção -> refinamento no trace), um substituto em software para os
+# contadores de hardware. Com --perf, cada instância roda mais uma vez no
+# modo de --perf-mode com e sem --relabel, e os contadores (cache misses,
+# instruções, ciclos; None onde o kernel não os expõe) vão para "perf".
+#
+# Exemplos:
+#   python3 benchmark.py -m 1 -m 2 -m "1 --relabel" -i a/instance_0005.txt -i x/instance_0014.txt
+#   python3 benchmark.py ... --save-baseline            # guarda em benchmarks/baseline.json
+#   python3 benchmark.py ... --baseline ../benchmarks/baseline.json
+#   python3 benchmark.py ... --perf --perf-mode 1
+
+ROOT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+SRC_DIR = os.path.abspath(os.path.dirname(__file__))
+SOLVER = os.path.join(SRC_DIR, "bin", "solver")
+DATASETS_DIR = os.path.join(ROOT_DIR, "datasets")
+BEST_PATH = os.path.join(ROOT_DIR, "best_solutions", "best_objectives.csv")
+BENCH_DIR = os.path.join(ROOT_DIR, "benchmarks")
+DEFAULT_BASELINE = os.path.join(BENCH_DIR, "baseline.json")
+
+TARGETS = [0.95, 0.99, 1.0]
+DEFAULT_INSTANCES = ["a/instance_0005.txt", "b/instance_0005.txt", "x/instance_0014.txt"]
+
+def read_best_objectives(path):
+    best = {}
+    with open(path) as f:
+        for row in csv.DictReader(f):
+            best[(row["dataset"], row["instance"])] = float(row["best_objective"])
+    return best
+
+def read_improvements(log_path):
+    """Lista (t, score) dos eventos 'best' do trace, em ordem de tempo."""
+    events = []
+    if not os.path.exists(log_path):
+        return events
+    with open(log_path) as f:
+        for line in f:
+            if line.strip():
+                event = json.loads(line)
+                if event.get("phase") == "best":
+                    events.append((float(event["t"]), float(event["score"])))
+    return sorted(events)
+
+def refinement_passes(log_path):
+    """Duração (s) de cada refinamento do trace, do evento de construção da
+    mesma thread ao de refinamento; rodadas puladas pelo cache de duplicatas
+    não contam."""
+    passes, built = [], {}
+    if not os.path.exists(log_path):
+        return passes
+    with open(log_path) as f:
+        for line in f:
+            if not line.strip():
+                continue
+            event = json.loads(line)
+            thread, phase = event.get("thread"), event.get("phase")
+            if phase == "construction":
+                built[thread] = float(event["t"])
+            elif phase == "skipped":
+                built.pop(thread, None)
+            elif phase == "refinement" and thread in built:
+                passes.append(float(event["t"]) - built.pop(thread))
+    return passes
+
+PERF_LINE = re.compile(r"Perf: (-?\d+) cache misses / (-?\d+) references.*?, (-?\d+) instructions, (-?\d+) cycles")
+
+def read_perf(stderr):
+    """Contadores da linha 'Perf:' do solver; None onde não há."""
+    counters = dict.fromkeys(["cache_misses", "cache_references", "instructions", "cycles"])
+    for line in stderr.splitlines():
+        match = PERF_LINE.match(line)
+        if match:
+            for key, value in zip(counters, match.groups()):
+                counters[key] = int(value) if int(value) >= 0 else None
+    return counters
+
+def time_to(events, target):
+    for t, score in events:
+        if score >= target - 1e-6:
+            return t
+    return None
+
+def launch(instance, mode, seed, threads, log_path):
+    """Roda o solver uma vez; devolve o stderr e a duração."""
+    if os.path.exists(log_path):
+        os.remove(log_path)
+    cmd = [SOLVER] + mode.split() + [log_path, "--seed", str(seed), "--threads", str(threads)]
+    start = time.time()
+    with open(os.path.join(DATASETS_DIR, instance)) as f_in:
+        result = subprocess.run(cmd, stdin=f_in, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    return result.stderr, time.time() - start
+
+def final_score(stderr):
+    final = 0.0
+    for line in stderr.splitlines():
+        if line.startswith("Final best"):
+            final = float(line.split()[2])
+    return final
+
+def run_once(instance, mode, seed, threads, log_path):
+    stderr, seconds = launch(instance, mode, seed, threads, log_path)
+    return final_score(stderr), seconds, read_improvements(log_path)
+
+def median_ms(passes):
+    return statistics.median(passes) * 1000.0 if passes else None
+
+def summarize(runs):
+    """Medianas sobre as repetições; um alvo não alcançado conta como None."""
+    summary = {"final_gap": statistics.median(r["final_gap"] for r in runs)}
+    passes = [r["refinement_ms"] for r in runs if r["refinement_ms"] is not None]
+    summary["refinement_ms"] = statistics.median(passes) if passes else None
+    for target in TARGETS:
+        key = f"ttt_{int(target * 100)}"
+        reached = [r[key] for r in runs if r[key] is not None]
+        summary[f"{key}_hits"] = len(reached)
+        # Mediana só quando a maioria das repetições chegou lá
+        summary[key] = statistics.median(reached) if len(reached) * 2 > len(runs) else None
+    return summary
+
+def benchmark(args):
+    best = read_best_objectives(BEST_PATH)
+    logs_dir = os.path.join(BENCH_DIR, "logs")
+    os.makedirs(logs_dir, exist_ok=True)
+
+    report = {"created": time.strftime("%Y-%m-%dT%H:%M:%S"), "reps": args.reps, "seed": args.seed,
+              "threads": args.threads, "results": {}}
+    for mode in args.mode:
+        for instance in args.instance:
+            dataset, name = instance.split("/")
+            if (dataset, name) not in best:
+                print(f"Sem best_objective para {instance}, pulando")
+                continue
+            reference = best[(dataset, name)]
+
+            runs = []
+            for rep in range(args.reps):
+                seed = args.seed + rep
+                log_path = os.path.join(logs_dir, f"{mode.replace(' ', '_')}_{dataset}_{name}_{seed}.jsonl")
+                final, seconds, events = run_once(instance, mode, seed, args.threads, log_path)
+                run = {"seed": seed, "final": final, "seconds": seconds,
+                       "final_gap": (reference - final) / reference * 100.0 if reference > 0 else 0.0,
+                       "refinement_ms": median_ms(refinement_passes(log_path))}
+                for target in TARGETS:
+                    run[f"ttt_{int(target * 100)}"] = time_to(events, target * reference)
+                runs.append(run)
+
+            summary = summarize(runs)
+            report["results"][f"{mode}|{instance}"] = {"mode": mode, "instance": instance,
+                                                       "best_objective": reference, "runs": runs, **summary}
+            ttt = "  ".join(f"{int(t * 100)}%: {fmt(summary[f'ttt_{int(t * 100)}'])}" for t in TARGETS)
+            print(f"[{mode}] {instance}: gap {summary['final_gap']:.2f}%  {ttt}  "
+                  f"refinamento {fmt_ms(summary['refinement_ms'])}")
+    if args.perf:
+        report["perf"] = perf(args, logs_dir)
+    return report
+
+def perf(args, logs_dir):
+    """Contadores de hardware e tempo por refinamento, com e sem --relabel."""
+    results = {}
+    for instance in args.instance:
+        dataset, name = instance.split("/")
+        entry = {}
+        for label, mode in (("plain", args.perf_mode), ("relabel", f"{args.perf_mode} --relabel")):
+            log_path = os.path.join(logs_dir, f"perf_{label}_{dataset}_{name}.jsonl")
+            stderr, seconds = launch(instance, f"{mode} --perf", args.seed, args.threads, log_path)
+            passes = refinement_passes(log_path)
+            entry[label] = {"mode": mode, "seconds": seconds, "final": final_score(stderr),
+                            "refinements": len(passes), "refinement_ms": median_ms(passes), **read_perf(stderr)}
+        results[instance] = entry
+        plain, relabel = entry["plain"], entry["relabel"]
+        misses = "  ".join(f"{label}: {fmt_count(entry[label]['cache_misses'])} misses"
+                           for label in ("plain", "relabel"))
+        print(f"[perf {args.perf_mode}] {instance}: {misses}  refinamento "
+              f"{fmt_ms(plain['refinement_ms'])} -> {fmt_ms(relabel['refinement_ms'])} com --relabel")
+    return results
+
+def fmt(seconds):
+    return "-" if seconds is None else f"{seconds:.2f}s"
+
+def fmt_ms(ms):
+    return "-" if ms is None else f"{ms:.2f}ms"
+
+def fmt_count(count):
+    return "-" if count is None else f"{count:,}"
+
+def compare(report, baseline, gap_tolerance, time_tolerance):
+    """Regressão: gap mediano pior que a tolerância (pontos percentuais), um
+    alvo que o baseline alcançava e agora não, ou um alvo alcançado mais de
+    `time_tolerance` vezes mais devagar (com folga de 0.1s para ruído)."""
+    regressions = []
+    for key, current in report["results"].items():
+        old = baseline["results"].get(key)
+        if old is None:
+            continue
+        if current["final_gap"] > old["final_gap"] + gap_tolerance:
+            regressions.append(f"{key}: gap {old['final_gap']:.2f}% -> {current['final_gap']:.2f}%")
+        for target in TARGETS:
+            k = f"ttt_{int(target * 100)}"
+            if old[k] is None:
+                continue
+            if current[k] is None:
+                regressions.append(f"{key}: {int(target * 100)}% alcançado em {fmt(old[k])}, agora não")
+            elif current[k] > old[k] * time_tolerance + 0.1:
+                regressions.append(f"{key}: {int(target * 100)}% em {fmt(old[k])} -> {fmt(current[k])}")
+    return regressions
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark de tempo-até-alvo contra best_objectives.csv")
+    parser.add_argument("-m", "--mode", action="append",
+                        help="heurística e flags do solver, ex.: '1' ou '2 --relabel' (repetível)")
+    parser.add_argument("-i", "--instance", action="append", help="dataset/instancia.txt (repetível)")
+    parser.add_argument("-r", "--reps", type=int, default=3)
+    parser.add_argument("-s", "--seed", type=int, default=1)
+    parser.add_argument("-t", "--threads", type=int, default=1)
+    parser.add_argument("-o", "--output", default=os.path.join(BENCH_DIR, "report.json"))
+    parser.add_argument("--baseline", help="relatório guardado para comparar (criado se não existe)")
+    parser.add_argument("--save-baseline", action="store_true", help=f"grava o relatório em {DEFAULT_BASELINE}")
+    parser.add_argument("--perf", action="store_true", help="contadores com e sem --relabel em cada instância")
+    parser.add_argument("--perf-mode", default="1", help="modo das rodadas de --perf")
+    parser.add_argument("--gap-tolerance", type=float, default=0.5)
+    parser.add_argument("--time-tolerance", type=float, default=1.25)
+    args = parser.parse_args()
+    args.mode = args.mode or ["1"]
+    args.instance = args.instance or DEFAULT_INSTANCES
+
+    if not os.path.exists(SOLVER):
+        print(f"Binário não encontrado: {SOLVER} (rode make)")
+        sys.exit(1)
+
+    # Verificado antes da rodada, que é longa: sem baseline, esta rodada vira o baseline
+    first_baseline = args.baseline and not os.path.exists(args.baseline)
+    if first_baseline:
+        print(f"Baseline {args.baseline} não existe; o relatório desta rodada será gravado nele")
+
+    report = benchmark(args)
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+    print(f"Relatório salvo em {args.output}")
+    if args.save_baseline:
+        with open(DEFAULT_BASELINE, "w") as f:
+            json.dump(report, f, indent=2)
+        print(f"Baseline salvo em {DEFAULT_BASELINE}")
+
+    if first_baseline:
+        os.makedirs(os.path.dirname(os.path.abspath(args.baseline)), exist_ok=True)
+        with open(args.baseline, "w") as f:
+            json.dump(report, f, indent=2)
+        print(f"Baseline salvo em {args.baseline}")
+    elif args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare(report, baseline, args.gap_tolerance, args.time_tolerance)
+        for r in regressions:
+            print(f"REGRESSÃO {r}")
+        if regressions:
+            sys.exit(1)
+        print("Sem regressões em relação ao baseline")
+
+if __name__ == "__main__":
+    main()
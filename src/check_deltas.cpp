@@ -0,0 +1,172 @@
+#include "include/common.hpp"
+#include "include/caches.hpp"
+
+#include <random>
+
+// Applies random stock changes, new orders and cancelled orders through the
+// delta API of Caches and State, with a random wave selected and moves in
+// between, and compares the result after every delta with Caches and a
+// State rebuilt from scratch on the changed Problem. The similarity
+// signatures are left out (they are sketches, not exact indexes).
+//
+// Usage: check_deltas <instance> [-n deltas] [-s seed]
+// Exits with 1 at the first difference.
+
+template<typename T>
+static vector<T> sorted(vector<T> v) {
+    std::sort(v.begin(), v.end(), [](const T &a, const T &b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+    return v;
+}
+
+template<typename T>
+static bool samePostings(const vector<T> &a, const vector<T> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i += 1)
+        if (a[i].first != b[i].first || a[i].second != b[i].second) return false;
+    return true;
+}
+
+// First difference between patched and rebuilt indexes, or "" if none.
+// Cancelled orders keep their id in the patched Caches but no postings.
+template<typename L>
+static std::string compareCaches(const Problem &p, const Caches<L> &patched, const Caches<L> &rebuilt,
+                                 const vector<bool> &cancelled) {
+    for (size_t item = 0; item < rebuilt.itemToAisles.size(); item += 1) {
+        if (!samePostings(patched.itemToAisles[item], rebuilt.itemToAisles[item]))
+            return "itemToAisles[" + std::to_string(item) + "]";
+        if (!samePostings(sorted(patched.itemToOrders[item]), sorted(rebuilt.itemToOrders[item])))
+            return "itemToOrders[" + std::to_string(item) + "]";
+        if (patched.globalItemAvailability[item] != rebuilt.globalItemAvailability[item])
+            return "globalItemAvailability[" + std::to_string(item) + "]";
+        if (patched.itemTopAisle[item] != rebuilt.itemTopAisle[item])
+            return "itemTopAisle[" + std::to_string(item) + "]";
+    }
+    for (size_t a = 0; a < p.aisles.size(); a += 1) {
+        if (!samePostings(patched.aisleToOrders[a], rebuilt.aisleToOrders[a]))
+            return "aisleToOrders[" + std::to_string(a) + "]";
+        if (patched.aisleAffinityUnits[a] != rebuilt.aisleAffinityUnits[a])
+            return "aisleAffinityUnits[" + std::to_string(a) + "]";
+    }
+    for (size_t o = 0; o < p.orders.size(); o += 1) {
+        if (!samePostings(patched.orderToAisles[o], rebuilt.orderToAisles[o]))
+            return "orderToAisles[" + std::to_string(o) + "]";
+        if (cancelled[o]) continue;
+        if (patched.orderTotalUnits[o] != rebuilt.orderTotalUnits[o])
+            return "orderTotalUnits[" + std::to_string(o) + "]";
+        uint32_t from = patched.orderLineStart[o], to = patched.orderLineStart[o + 1], start = rebuilt.orderLineStart[o];
+        if (to - from != rebuilt.orderLineStart[o + 1] - start) return "order lines of " + std::to_string(o);
+        for (uint32_t k = 0; k < to - from; k += 1) {
+            if (patched.orderLineItem[from + k] != rebuilt.orderLineItem[start + k]
+                || patched.orderLineQty[from + k] != rebuilt.orderLineQty[start + k]
+                || patched.orderLineOwner[from + k] != rebuilt.orderLineOwner[start + k])
+                return "order lines of " + std::to_string(o);
+        }
+    }
+    return "";
+}
+
+template<typename L>
+static std::string compareStates(const State<L> &patched, const State<L> &rebuilt) {
+    if (patched.itemBalance != rebuilt.itemBalance) return "itemBalance";
+    if (patched.deficitItems != rebuilt.deficitItems) return "deficitItems";
+    if (patched.currentTotalUnits != rebuilt.currentTotalUnits) return "currentTotalUnits";
+    if (patched.aisleSelected != rebuilt.aisleSelected) return "aisleSelected";
+    if (patched.orderSelected != rebuilt.orderSelected) return "orderSelected";
+    if (patched.aisleGainBound != rebuilt.aisleGainBound) return "aisleGainBound";
+    if (patched.itemNeed != rebuilt.itemNeed) return "itemNeed";
+    if (patched.aisleHash != rebuilt.aisleHash || patched.orderHash != rebuilt.orderHash) return "hashes";
+    return "";
+}
+
+template<typename L>
+static int check(Problem p, int deltas, unsigned seed, const char *layout) {
+    std::mt19937 rng(seed);
+    auto uniform = [&](int n) { return std::uniform_int_distribution<>(0, n - 1)(rng); };
+
+    Caches<L> c(p);
+    Solution s;
+    State<L> state(p, c, s);
+    for (int k = 0; k < (int)p.aisles.size() / 4; k += 1) state.addAisle(uniform(p.aisles.size()));
+    for (int k = 0; k < (int)p.orders.size() / 4; k += 1) state.addOrder(uniform(p.orders.size()));
+
+    vector<bool> cancelled(p.orders.size(), false);
+    for (int step = 0; step < deltas; step += 1) {
+        std::string what;
+        int kind = uniform(3);
+        if (kind == 0) {
+            // Restock, empty or newly stock an item of an aisle
+            int aisle = uniform(p.aisles.size());
+            int item = !p.aisles[aisle].empty() && uniform(2) ? p.aisles[aisle][uniform(p.aisles[aisle].size())].ff
+                                                              : uniform(p.itemCount);
+            int qty = uniform(3) == 0 ? 0 : 1 + uniform(10);
+            int old = p.setAisleStock(aisle, item, qty);
+            if (!c.updateAisleStock(p, aisle, item, old, qty)) return std::cerr << "Stock change does not fit the layout" << std::endl, 1;
+            state.aisleStockChanged(aisle, item, old, qty);
+            what = "stock of item " + std::to_string(item) + " in aisle " + std::to_string(aisle);
+        } else if (kind == 1) {
+            vector<pair<int, int>> lines;
+            std::set<int> items;
+            for (int k = 1 + uniform(4); k > 0; k -= 1) items.insert(uniform(p.itemCount));
+            for (int item : items) lines.push_back({item, 1 + uniform(5)});
+            int order = p.addOrder(lines);
+            if (!c.addOrder(p, order)) return std::cerr << "New order does not fit the layout" << std::endl, 1;
+            state.orderAdded(order);
+            cancelled.push_back(false);
+            what = "new order " + std::to_string(order);
+        } else {
+            int order = uniform(p.orders.size());
+            if (cancelled[order]) continue;
+            state.orderRemoving(order);
+            c.removeOrder(p, order);
+            p.clearOrder(order);
+            cancelled[order] = true;
+            what = "cancelled order " + std::to_string(order);
+        }
+
+        // Moves between deltas, so that the patched State keeps changing
+        for (int k = 0; k < 4; k += 1) {
+            int aisle = uniform(p.aisles.size()), order = uniform(p.orders.size());
+            if (uniform(2)) state.addAisle(aisle); else state.removeAisle(aisle);
+            if (cancelled[order]) continue;
+            if (uniform(2)) state.addOrder(order); else state.removeOrder(order);
+        }
+
+        Caches<L> rebuilt(p);
+        Solution copy = s;
+        State<L> fresh(p, rebuilt, copy);
+        std::string differs = compareCaches(p, c, rebuilt, cancelled);
+        if (differs.empty()) differs = compareStates(state, fresh);
+        if (!differs.empty()) {
+            std::cerr << "Delta " << step << " (" << what << ", " << layout << " layout): " << differs
+                      << " differs from a rebuild" << std::endl;
+            return 1;
+        }
+    }
+    cout << "check_deltas: " << deltas << " deltas on the " << layout << " layout match a rebuild" << endl;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <instance> [-n deltas] [-s seed]" << std::endl;
+        return 1;
+    }
+    int deltas = 200;
+    unsigned seed = 1;
+    for (int i = 2; i < argc; i += 2) {
+        std::string flag = argv[i];
+        if (i + 1 >= argc) { std::cerr << "Missing value for " << flag << std::endl; return 1; }
+        if (flag == "-n") deltas = std::stoi(argv[i + 1]);
+        else if (flag == "-s") seed = std::stoul(argv[i + 1]);
+        else { std::cerr << "Unknown option " << flag << std::endl; return 1; }
+    }
+
+    Problem p;
+    if (!Problem::ReadFromFile(argv[1], p)) { std::cerr << "Cannot read " << argv[1] << std::endl; return 1; }
+    if (p.orders.empty() || p.aisles.empty() || p.itemCount == 0) { std::cerr << "Empty instance" << std::endl; return 1; }
+
+    if (check<SmallLayout>(p, deltas, seed, "small")) return 1;
+    return check<WideLayout>(p, deltas, seed, "wide");
+}
@@ -0,0 +1,90 @@
+#include "include/common.hpp"
+#include "include/checker.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace fs = std::filesystem;
+
+// Usage:
+//   checker <instance> <output> [--slack]
+//   checker --batch <datasets dir> <results dir> [--csv out.csv]
+//
+// Single mode prints the objective, violations and (with --slack) the
+// per-item slack, and exits with 2 when the wave is infeasible.
+// Batch mode checks every <results>/<set>/<name>.txt against
+// <datasets>/<set>/<name>.txt and writes one CSV line per result.
+
+static int checkOne(const std::string &instancePath, const std::string &outputPath, bool slack) {
+    Problem p;
+    Checker::RawSolution s;
+    if (!Problem::ReadFromFile(instancePath, p)) { std::cerr << "Cannot read " << instancePath << std::endl; return 1; }
+    if (!Checker::readSolutionFile(outputPath, s)) { std::cerr << "Cannot read " << outputPath << std::endl; return 1; }
+
+    auto r = Checker::check(p, s);
+    cout << "feasible: " << (r.feasible ? "yes" : "no") << '\n'
+         << "objective: " << std::setprecision(17) << r.objective << '\n'
+         << "units: " << r.units << " (lb " << p.lb << ", ub " << p.ub << ")\n"
+         << "orders: " << r.orders << '\n'
+         << "aisles: " << r.aisles << '\n';
+    for (const auto &v : r.violations) cout << "violation: " << v << '\n';
+
+    if (slack) {
+        cout << "item required available slack\n";
+        for (const auto &i : r.items)
+            cout << i.item << ' ' << i.required << ' ' << i.available << ' ' << i.available - i.required << '\n';
+    }
+    return r.feasible ? 0 : 2;
+}
+
+static int checkBatch(const std::string &datasetsDir, const std::string &resultsDir, const std::string &csvPath) {
+    vector<fs::path> outputs;
+    for (const auto &entry : fs::recursive_directory_iterator(resultsDir))
+        if (entry.is_regular_file() && entry.path().extension() == ".txt")
+            outputs.pb(entry.path());
+    std::sort(all(outputs));
+
+    std::ofstream file;
+    if (!csvPath.empty()) file.open(csvPath);
+    std::ostream &out = csvPath.empty() ? cout : file;
+
+    out << "dataset,instance,objective,feasible,units,orders,aisles,violations,milliseconds\n";
+    int infeasible = 0;
+    for (const auto &output : outputs) {
+        std::string dataset = output.parent_path().filename().string();
+        fs::path instance = fs::path(datasetsDir) / dataset / output.filename();
+        if (!fs::exists(instance)) continue;
+
+        auto start = chrono::high_resolution_clock::now();
+        Problem p;
+        Checker::RawSolution s;
+        if (!Problem::ReadFromFile(instance.string(), p) || !Checker::readSolutionFile(output.string(), s)) {
+            std::cerr << "Cannot read " << output << std::endl;
+            continue;
+        }
+        auto r = Checker::check(p, s);
+        chrono::duration<double, std::milli> elapsed = chrono::high_resolution_clock::now() - start;
+
+        if (!r.feasible) infeasible += 1;
+        out << dataset << ',' << output.filename().string() << ',' << std::setprecision(17) << r.objective << ','
+            << (r.feasible ? 1 : 0) << ',' << r.units << ',' << r.orders << ',' << r.aisles << ','
+            << r.violations.size() << ',' << std::setprecision(4) << elapsed.count() << '\n';
+    }
+    return infeasible == 0 ? 0 : 2;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 4 && std::string(argv[1]) == "--batch") {
+        std::string csvPath;
+        if (argc >= 6 && std::string(argv[4]) == "--csv") csvPath = argv[5];
+        return checkBatch(argv[2], argv[3], csvPath);
+    }
+    if (argc >= 3) {
+        bool slack = argc >= 4 && std::string(argv[3]) == "--slack";
+        return checkOne(argv[1], argv[2], slack);
+    }
+    std::cerr << "Usage: " << argv[0] << " <instance> <output> [--slack]" << std::endl
+              << "       " << argv[0] << " --batch <datasets dir> <results dir> [--csv out.csv]" << std::endl;
+    return 1;
+}
@@ -1,4 +1,5 @@
 import os
+import json
 import matplotlib.pyplot as plt
 import sys
 
@@ -7,24 +8,38 @@ ROOT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 LOGS_DIR = os.path.join(ROOT_DIR, "convergence_logs")
 PLOTS_DIR = os.path.join(ROOT_DIR, "plots", "convergence")
 
+def read_log(log_file):
+    """Lê (tempos, scores) das melhorias; aceita o trace .jsonl ou o log antigo 'tempo score'."""
+    times, scores = [], []
+    with open(log_file, 'r') as f:
+        if log_file.endswith(".jsonl"):
+            for line in f:
+                if not line.strip():
+                    continue
+                event = json.loads(line)
+                if event.get("phase") == "best":
+                    times.append(float(event["t"]))
+                    scores.append(float(event["score"]))
+        else:
+            for line in f:
+                parts = line.strip().split()
+                if len(parts) >= 2:
+                    times.append(float(parts[0]))
+                    scores.append(float(parts[1]))
+    return times, scores
+
 def plot_instance(set_name, instance_name):
-    log_file = os.path.join(LOGS_DIR, set_name, f"{instance_name}.log")
-    
+    log_file = os.path.join(LOGS_DIR, set_name, f"{instance_name}.jsonl")
+    if not os.path.exists(log_file):
+        log_file = os.path.join(LOGS_DIR, set_name, f"{instance_name}.log")
+
     if not os.path.exists(log_file):
         print(f"Log não encontrado: {log_file}")
         return
 
-    times = []
-    scores = []
-
     # Leitura do arquivo de log
     try:
-        with open(log_file, 'r') as f:
-            for line in f:
-                parts = line.strip().split()
-                if len(parts) >= 2:
-                    times.append(float(parts[0]))
-                    scores.append(float(parts[1]))
+        times, scores = read_log(log_file)
     except Exception as e:
         print(f"Erro ao ler log {instance_name}: {e}")
         return
@@ -64,8 +79,7 @@ if __name__ == "__main__":
     for s in sets:
         set_path = os.path.join(LOGS_DIR, s)
         if os.path.exists(set_path):
-            files = sorted([f for f in os.listdir(set_path) if f.endswith(".log")])
-            for filename in files:
-                inst_name = os.path.splitext(filename)[0]
+            files = sorted([f for f in os.listdir(set_path) if f.endswith(".log") or f.endswith(".jsonl")])
+            for inst_name in sorted(set(os.path.splitext(f)[0] for f in files)):
                 plot_instance(s, inst_name)
     print("--- Concluído ---")
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "include/common.hpp"
+
+#include <cmath>
+
+// Writes a synthetic instance, in the text format of datasets/, to stdout.
+// Item popularity follows a Zipf law over a random permutation of the item
+// ids: order lines and aisle lines both favour the popular items, as in the
+// real snapshots, so the hard part of the problem (a few items everybody
+// wants) scales with the instance. Aisle stock is sized from the demand that
+// was actually drawn, `-S` times over, so every order can be served alone.
+//
+// Usage: generator [-o orders] [-i items] [-a aisles] [-z zipf_s] [-l lines_per_order]
+//                  [-q max_qty] [-L lines_per_aisle] [-S supply] [--lb lb] [--ub ub] [-s seed]
+
+struct Params {
+    ll orders = 100000, items = 20000, aisles = 500;
+    double zipf = 1.0;          // popularity of the k-th item ~ 1 / k^zipf
+    double lines = 3.5;         // mean lines per order, geometric, at least 1
+    int maxQty = 4;             // order quantities in [1, maxQty], small ones likelier
+    ll aisleLines = 0;          // Zipf lines per aisle on top of its share of items; 0 = two copies per item
+    double supply = 1.5;        // stock over demand
+    ll lb = -1, ub = -1;        // -1 = from the demand drawn
+    unsigned seed = 0;
+};
+
+// Numbers straight into a big buffer: a million-order instance is ~40 MB
+struct Writer {
+    std::string buffer;
+
+    ~Writer() { flush(); }
+
+    void flush() {
+        fwrite(buffer.data(), 1, buffer.size(), stdout);
+        buffer.clear();
+    }
+
+    void put(ll x) {
+        char digits[24];
+        int n = 0;
+        do { digits[n++] = '0' + x % 10; x /= 10; } while (x > 0);
+        while (n > 0) buffer += digits[--n];
+    }
+
+    void put(char c) {
+        buffer += c;
+        if (buffer.size() >= (1 << 20)) flush();
+    }
+};
+
+// Inverse-CDF sampling of the popularity rank, mapped to a shuffled item id
+struct Zipf {
+    vector<double> cdf;
+    vector<int> itemOfRank;
+
+    Zipf(ll items, double s, mt19937_64 &rng) : cdf(items), itemOfRank(items) {
+        double total = 0.0;
+        for (ll k = 0; k < items; k += 1) cdf[k] = total += 1.0 / std::pow((double)(k + 1), s);
+        for (auto &c : cdf) c /= total;
+        iota(all(itemOfRank), 0);
+        std::shuffle(all(itemOfRank), rng);
+    }
+
+    int operator()(mt19937_64 &rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t rank = std::lower_bound(all(cdf), u) - cdf.begin();
+        return itemOfRank[min(rank, cdf.size() - 1)];
+    }
+};
+
+// Distinct items for one line set, marked in `seen` with a stamp per set
+struct Picker {
+    vector<ll> seen;
+    ll stamp = 0;
+    vector<int> picked;
+
+    explicit Picker(ll items) : seen(items, 0) {}
+
+    void begin() {
+        stamp += 1;
+        picked.clear();
+    }
+
+    void add(int item) {
+        if (seen[item] == stamp) return;
+        seen[item] = stamp;
+        picked.pb(item);
+    }
+
+    // Up to `count` lines in all; rejection gives up on a saturated head
+    const vector<int> &fill(const Zipf &zipf, ll count, mt19937_64 &rng) {
+        count = min<ll>(count, seen.size());
+        for (ll tries = 0; (ll)picked.size() < count && tries < 64 * count; tries += 1) add(zipf(rng));
+        return picked;
+    }
+};
+
+int main(int argc, char *argv[]) {
+    Params q;
+    q.seed = std::random_device{}();
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i], value = argv[i + 1];
+        if (flag == "-o") q.orders = std::stoll(value);
+        else if (flag == "-i") q.items = std::stoll(value);
+        else if (flag == "-a") q.aisles = std::stoll(value);
+        else if (flag == "-z") q.zipf = std::stod(value);
+        else if (flag == "-l") q.lines = std::stod(value);
+        else if (flag == "-q") q.maxQty = std::stoi(value);
+        else if (flag == "-L") q.aisleLines = std::stoll(value);
+        else if (flag == "-S") q.supply = std::stod(value);
+        else if (flag == "--lb") q.lb = std::stoll(value);
+        else if (flag == "--ub") q.ub = std::stoll(value);
+        else if (flag == "-s") q.seed = std::stoul(value);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [-o orders] [-i items] [-a aisles] [-z zipf_s] [-l lines_per_order]"
+                      << " [-q max_qty] [-L lines_per_aisle] [-S supply] [--lb lb] [--ub ub] [-s seed]" << std::endl;
+            return 1;
+        }
+    }
+    if (q.orders < 1 || q.items < 1 || q.aisles < 1 || q.lines < 1 || q.maxQty < 1) {
+        std::cerr << "Counts, lines and quantities must be positive" << std::endl;
+        return 1;
+    }
+    if (q.aisleLines == 0) q.aisleLines = max<ll>(1, 2 * q.items / q.aisles);
+
+    mt19937_64 rng(q.seed);
+    Zipf zipf(q.items, q.zipf, rng);
+    std::geometric_distribution<ll> extraLines(1.0 / q.lines);
+    std::geometric_distribution<int> extraQty(0.6);
+
+    Writer out;
+    out.put(q.orders); out.put(' '); out.put(q.items); out.put(' '); out.put(q.aisles); out.put('\n');
+
+    Picker picker(q.items);
+    ll demand = 0;
+    vector<ll> itemDemand(q.items, 0);
+    for (ll o = 0; o < q.orders; o += 1) {
+        picker.begin();
+        const vector<int> &picked = picker.fill(zipf, 1 + extraLines(rng), rng);
+        out.put((ll)picked.size());
+        for (int item : picked) {
+            int qty = min(q.maxQty, 1 + extraQty(rng));
+            demand += qty;
+            itemDemand[item] += qty;
+            out.put(' '); out.put((ll)item); out.put(' '); out.put((ll)qty);
+        }
+        out.put(' '); out.put('\n');
+    }
+
+    // Every item is in some aisle (ranks dealt round-robin), and the Zipf
+    // draws on top put popular items in many. An item's stock, `-S` times
+    // its demand, is split over its copies.
+    vector<vector<int>> aisleItems(q.aisles);
+    vector<ll> copies(q.items, 0);
+    for (ll a = 0; a < q.aisles; a += 1) {
+        picker.begin();
+        for (ll rank = a; rank < q.items; rank += q.aisles) picker.add(zipf.itemOfRank[rank]);
+        aisleItems[a] = picker.fill(zipf, (ll)picker.picked.size() + q.aisleLines, rng);
+        for (int item : aisleItems[a]) copies[item] += 1;
+    }
+
+    std::uniform_real_distribution<double> jitter(0.5, 1.5);
+    for (ll a = 0; a < q.aisles; a += 1) {
+        out.put((ll)aisleItems[a].size());
+        for (int item : aisleItems[a]) {
+            double share = q.supply * itemDemand[item] / copies[item];
+            ll qty = max<ll>(1, std::llround(share * jitter(rng)));
+            out.put(' '); out.put((ll)item); out.put(' '); out.put(qty);
+        }
+        out.put(' '); out.put('\n');
+    }
+
+    // The datasets put ub between a third and a tenth of all demand
+    ll ub = q.ub >= 0 ? q.ub : max<ll>(1, demand / 5);
+    ll lb = q.lb >= 0 ? q.lb : ub / 4;
+    out.put(lb); out.put(' '); out.put(ub); out.put('\n');
+
+    std::cerr << "Generated " << q.orders << " orders, " << q.items << " items, " << q.aisles
+              << " aisles, " << demand << " units demanded, seed " << q.seed << std::endl;
+    return 0;
+}
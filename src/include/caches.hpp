@@ -1,31 +1,144 @@
 #pragma once
 
 #include "common.hpp"
+#include "similarity.hpp"
+#include "screen.hpp"
+#include "dedup.hpp"
 #include <random>
+#include <climits>
+#include <limits>
+#include <cassert>
 
 using namespace std;
 
+/**
+ * INDEX LAYOUTS
+ * Integer widths used inside Caches and State. Aisle ids stay below ~500 and
+ * quantities are small, so most instances fit the narrow layouts and the
+ * inverted indexes / balance arrays take 2-4x less cache.
+ * chooseLayout() picks the narrowest safe layout once, after reading.
+ */
+template<typename AisleId, typename OrderId, typename Quantity, typename Balance>
+struct Layout {
+    typedef AisleId aisle_t;
+    typedef OrderId order_t;
+    typedef Quantity qty_t;
+    typedef Balance balance_t; // Holds +stock and -demand of one item, and wave units
+};
+
+typedef Layout<uint16_t, uint16_t, uint16_t, int32_t> SmallLayout;
+typedef Layout<uint16_t, uint32_t, uint16_t, int32_t> MediumLayout;
+typedef Layout<int32_t, int32_t, int32_t, ll> WideLayout;
+
+enum class LayoutKind { Small, Medium, Wide };
+
+inline const char *layoutName(LayoutKind kind) {
+    switch (kind) {
+        case LayoutKind::Small: return "small (16-bit orders)";
+        case LayoutKind::Medium: return "medium (32-bit orders)";
+        case LayoutKind::Wide: return "wide";
+    }
+    return "?";
+}
+
+inline LayoutKind chooseLayout(const Problem &p) {
+    ll maxQty = 0;
+    vector<ll> stock(p.itemCount + 1, 0);
+    ll totalDemand = 0;
+    for (const auto &aisle : p.aisles)
+        for (const auto &line : aisle) {
+            maxQty = max<ll>(maxQty, line.ss);
+            stock[line.ff] += line.ss;
+        }
+    for (const auto &order : p.orders)
+        for (const auto &line : order) {
+            maxQty = max<ll>(maxQty, line.ss);
+            totalDemand += line.ss;
+        }
+
+    bool narrowQty = maxQty <= UINT16_MAX;
+    bool narrowBalance = totalDemand <= INT32_MAX && p.ub <= INT32_MAX;
+    for (size_t i = 0; i < stock.size() && narrowBalance; i += 1)
+        narrowBalance = stock[i] <= INT32_MAX;
+
+    if (!narrowQty || !narrowBalance || p.aisles.size() > UINT16_MAX) return LayoutKind::Wide;
+    if (p.orders.size() <= UINT16_MAX) return LayoutKind::Small;
+    if (p.orders.size() <= UINT32_MAX) return LayoutKind::Medium;
+    return LayoutKind::Wide;
+}
+
+// Packed (quantity, index) entry of an inverted index; a std::pair would pad
+// a 16-bit quantity next to a 32-bit order id to 8 bytes.
+#pragma pack(push, 1)
+template<typename Q, typename I>
+struct Posting {
+    Q first;
+    I second;
+
+    bool operator<(const Posting &o) const {
+        return first != o.first ? first < o.first : second < o.second;
+    }
+};
+#pragma pack(pop)
+
 /**
  * IMMUTABLE CACHE
  * Calculated once per Problem instance.
  * Provides O(1) access to static relationships and precomputed sums.
+ *
+ * Stock replenishment and new or cancelled orders can be applied in place,
+ * in time proportional to the postings of the touched items. For a stock
+ * change: Problem::setAisleStock, then updateAisleStock, then
+ * State::aisleStockChanged. For a new order: Problem::addOrder, addOrder,
+ * State::orderAdded. For a cancelled one: State::orderRemoving,
+ * removeOrder, Problem::clearOrder. A false return means the value does
+ * not fit the layout, and the Caches must be rebuilt.
  */
+template<typename L>
 struct Caches {
+    typedef typename L::aisle_t aisle_t;
+    typedef typename L::order_t order_t;
+    typedef typename L::qty_t qty_t;
+    typedef typename L::balance_t balance_t;
+
     // Inverse Index: item_id -> list of {quantity, aisle_index}
     // Optimization: Sorted by quantity descending.
     // Usage: When an order needs item X, quickly find the aisle with the most of X.
-    vector<vector<pair<int, int>>> itemToAisles;
+    vector<vector<Posting<qty_t, aisle_t>>> itemToAisles;
 
     // Inverse Index: item_id -> list of {quantity, order_index}
     // Usage: If we pick an aisle with item X, which orders does this help?
-    vector<vector<pair<int, int>>> itemToOrders;
+    vector<vector<Posting<qty_t, order_t>>> itemToOrders;
 
     // Precomputed total units per order (the numerator for the greedy score)
-    vector<ll> orderTotalUnits;
+    vector<balance_t> orderTotalUnits;
 
     // The maximum possible quantity of an item available in the entire warehouse.
     // Usage: Fast fail if an order requests more than physically exists.
-    vector<ll> globalItemAvailability;
+    vector<balance_t> globalItemAvailability;
+
+    // Sparse affinity index: aisle -> list of {units it can supply, order_index}
+    // "Units it can supply" is sum over the order's lines of min(order qty, aisle qty),
+    // so an entry equal to orderTotalUnits means the aisle alone covers the order.
+    // Usage: gain of opening an aisle without walking itemToOrders for each of its items.
+    vector<vector<Posting<balance_t, order_t>>> aisleToOrders;
+
+    // Reverse of aisleToOrders: order -> list of {units supplied, aisle_index}
+    vector<vector<Posting<balance_t, aisle_t>>> orderToAisles;
+
+    // Sum of aisleToOrders[a]: the gain of aisle a when no order is selected
+    vector<ll> aisleAffinityUnits;
+
+    // MinHash/LSH over item sets: top-k similar aisles or orders without scanning postings
+    SimilarityIndex similarity;
+
+    // Flat copy of the order lines (CSR): order o owns [orderLineStart[o], orderLineStart[o + 1]).
+    // Padded with Screen::PADDING entries so the vector kernels can read past the last order.
+    vector<uint32_t> orderLineStart;
+    vector<int32_t> orderLineItem, orderLineQty, orderLineOwner;
+
+    // Aisle with the most of each item (-1 if none), for the new-aisle estimate
+    vector<int32_t> itemTopAisle;
 
     Caches(const Problem &p) {
         // 1. Resize everything based on itemCount (assuming item IDs are 0..itemCount-1)
@@ -45,7 +158,7 @@ struct Caches {
                 int item = line.ff;
                 int quant = line.ss;
                 if(item < size) {
-                    itemToAisles[item].push_back({quant, i});
+                    itemToAisles[item].push_back({(qty_t)quant, (aisle_t)i});
                     globalItemAvailability[item] += quant;
                 }
             }
@@ -53,12 +166,12 @@ struct Caches {
 
         // 3. Process Orders (Build itemToOrders and orderTotalUnits)
         for(int i = 0; i < p.orders.size(); ++i) {
-            ll currentOrderUnits = 0;
+            balance_t currentOrderUnits = 0;
             for(const auto& line : p.orders[i]) {
                 int item = line.ff;
                 int quant = line.ss;
                 if(item < size) {
-                    itemToOrders[item].push_back({quant, i});
+                    itemToOrders[item].push_back({(qty_t)quant, (order_t)i});
                 }
                 currentOrderUnits += quant;
             }
@@ -71,6 +184,164 @@ struct Caches {
         for(auto& vec : itemToAisles) {
             sort(vec.rbegin(), vec.rend());
         }
+
+        // 5. Join aisles with orders through their shared items
+        aisleToOrders.resize(p.aisles.size());
+        orderToAisles.resize(p.orders.size());
+        aisleAffinityUnits.resize(p.aisles.size(), 0);
+        vector<balance_t> supplied(p.orders.size(), 0);
+        vector<int> touched;
+        for(int a = 0; a < p.aisles.size(); ++a) {
+            for(const auto& line : p.aisles[a]) {
+                if(line.ff >= size) continue;
+                for(const auto& posting : itemToOrders[line.ff]) {
+                    if(supplied[posting.second] == 0) touched.push_back(posting.second);
+                    supplied[posting.second] += min<balance_t>(posting.first, line.ss);
+                }
+            }
+            sort(touched.begin(), touched.end());
+            aisleToOrders[a].reserve(touched.size());
+            for(int o : touched) {
+                aisleToOrders[a].push_back({supplied[o], (order_t)o});
+                orderToAisles[o].push_back({supplied[o], (aisle_t)a});
+                aisleAffinityUnits[a] += supplied[o];
+                supplied[o] = 0;
+            }
+            touched.clear();
+        }
+
+        // 6. Similarity signatures
+        similarity.build(p);
+
+        // 7. Flat order lines for the screening kernels
+        orderLineStart.reserve(p.orders.size() + 1);
+        orderLineStart.push_back(0);
+        for(const auto &order : p.orders) {
+            for(const auto &line : order) {
+                orderLineItem.push_back(min(line.ff, size - 1));
+                orderLineQty.push_back(line.ss);
+                orderLineOwner.push_back(orderLineStart.size() - 1);
+            }
+            orderLineStart.push_back(orderLineItem.size());
+        }
+        orderLineItem.resize(orderLineItem.size() + Screen::PADDING, 0);
+        orderLineQty.resize(orderLineQty.size() + Screen::PADDING, 0);
+
+        itemTopAisle.resize(size, -1);
+        for(int item = 0; item < size; ++item)
+            if(!itemToAisles[item].empty()) itemTopAisle[item] = itemToAisles[item][0].second;
+    }
+
+    template<typename T>
+    static bool representable(ll value) {
+        return value >= 0 && value <= (ll)std::numeric_limits<T>::max();
+    }
+
+    // Sets a {supplied, id} entry of an id-sorted affinity list, dropping it at 0
+    template<typename Q, typename I>
+    static void adjustAffinity(vector<Posting<Q, I>> &list, int id, balance_t delta) {
+        auto at = std::lower_bound(list.begin(), list.end(), id, [](const Posting<Q, I> &e, int key) {
+            return (int)e.second < key;
+        });
+        if (at != list.end() && (int)at->second == id) {
+            at->first += delta;
+            if (at->first == 0) list.erase(at);
+        } else {
+            list.insert(at, {(Q)delta, (I)id});
+        }
+    }
+
+    // After Problem::setAisleStock(aisle, item, newQty) returned oldQty
+    bool updateAisleStock(const Problem &p, int aisle, int item, int oldQty, int newQty) {
+        if (item < 0 || item >= (int)itemToAisles.size() - 1 || !representable<qty_t>(newQty)
+            || !representable<balance_t>(globalItemAvailability[item] + newQty - oldQty)) return false;
+
+        auto &providers = itemToAisles[item];
+        if (oldQty > 0) {
+            auto at = std::find_if(providers.begin(), providers.end(), [&](auto &e) { return (int)e.second == aisle; });
+            if (at != providers.end()) providers.erase(at);
+        }
+        if (newQty > 0) {
+            Posting<qty_t, aisle_t> entry{(qty_t)newQty, (aisle_t)aisle};
+            // Same order as the constructor: descending by quantity, then by aisle
+            auto at = std::upper_bound(providers.begin(), providers.end(), entry, [](auto &a, auto &b) { return b < a; });
+            providers.insert(at, entry);
+        }
+        globalItemAvailability[item] += newQty - oldQty;
+        itemTopAisle[item] = providers.empty() ? -1 : providers[0].second;
+
+        for (const auto &posting : itemToOrders[item]) {
+            balance_t delta = min<balance_t>(posting.first, newQty) - min<balance_t>(posting.first, oldQty);
+            if (delta == 0) continue;
+            adjustAffinity(aisleToOrders[aisle], posting.second, delta);
+            adjustAffinity(orderToAisles[posting.second], aisle, delta);
+            aisleAffinityUnits[aisle] += delta;
+        }
+
+        if (oldQty == 0 || newQty == 0) similarity.updateAisle(aisle, p.aisles[aisle]);
+        return true;
+    }
+
+    // After Problem::addOrder returned orderIdx
+    bool addOrder(const Problem &p, int orderIdx) {
+        const auto &lines = p.orders[orderIdx];
+        ll units = 0;
+        bool fits = representable<order_t>(orderIdx);
+        for (const auto &line : lines) {
+            fits = fits && line.ff >= 0 && line.ff < (int)itemToOrders.size() - 1 && representable<qty_t>(line.ss);
+            units += line.ss;
+        }
+        if (!fits || !representable<balance_t>(units)) return false;
+
+        orderTotalUnits.push_back(units);
+        std::map<int, balance_t> supplied;
+        for (const auto &line : lines) {
+            itemToOrders[line.ff].push_back({(qty_t)line.ss, (order_t)orderIdx});
+            for (const auto &posting : itemToAisles[line.ff])
+                supplied[posting.second] += min<balance_t>(posting.first, line.ss);
+        }
+        orderToAisles.emplace_back();
+        for (const auto &[a, units] : supplied) {
+            aisleToOrders[a].push_back({units, (order_t)orderIdx});
+            orderToAisles[orderIdx].push_back({units, (aisle_t)a});
+            aisleAffinityUnits[a] += units;
+        }
+        similarity.updateOrder(orderIdx, lines);
+
+        orderLineItem.resize(orderLineStart.back());
+        orderLineQty.resize(orderLineStart.back());
+        for (const auto &line : lines) {
+            orderLineItem.push_back(line.ff);
+            orderLineQty.push_back(line.ss);
+            orderLineOwner.push_back(orderIdx);
+        }
+        orderLineStart.push_back(orderLineItem.size());
+        orderLineItem.resize(orderLineItem.size() + Screen::PADDING, 0);
+        orderLineQty.resize(orderLineQty.size() + Screen::PADDING, 0);
+        return true;
+    }
+
+    // Before Problem::clearOrder(orderIdx). The order keeps its id with no
+    // postings, and units past any bound so that every fit test rejects it;
+    // its flat lines point at the spare item slot with quantity 0.
+    void removeOrder(const Problem &p, int orderIdx) {
+        for (const auto &line : p.orders[orderIdx]) {
+            auto &postings = itemToOrders[line.ff];
+            auto at = std::find_if(postings.begin(), postings.end(), [&](auto &e) { return (int)e.second == orderIdx; });
+            if (at != postings.end()) postings.erase(at);
+        }
+        for (const auto &posting : orderToAisles[orderIdx]) {
+            adjustAffinity(aisleToOrders[posting.second], orderIdx, -posting.first);
+            aisleAffinityUnits[posting.second] -= posting.first;
+        }
+        orderToAisles[orderIdx].clear();
+        orderTotalUnits[orderIdx] = (balance_t)min<ll>(std::numeric_limits<balance_t>::max(), LLONG_MAX / 4);
+        similarity.updateOrder(orderIdx, {});
+
+        for (uint32_t k = orderLineStart[orderIdx]; k < orderLineStart[orderIdx + 1]; k += 1) {
+            orderLineItem[k] = itemToAisles.size() - 1;
+            orderLineQty[k] = 0;
+        }
     }
 };
 
@@ -79,13 +350,16 @@ struct Caches {
  * Maintained during construction/refinement.
  * Allows O(1) delta updates instead of full re-scans.
  */
+template<typename L>
 struct State {
+    typedef typename L::balance_t balance_t;
+
     const Problem& p;
-    const Caches& c;
+    const Caches<L>& c;
 
     // Tracks: (Available Quantity - Required Quantity) for each item.
     // If balance[i] < 0, we have a deficit.
-    vector<ll> itemBalance;
+    vector<balance_t> itemBalance;
 
     // Tracks how unique items with a deficit (balance < 0).
     // If deficitItemCount == 0, the solution is FEASIBLE regarding items.
@@ -101,15 +375,58 @@ struct State {
     std::unordered_set<int> &aisleSolution;
     std::unordered_set<int> &orderSolution;
 
-    State(const Problem &prob, const Caches &caches, Solution &sol)
+    // Zobrist hashes of the selections: XOR of Dedup::aisleKey/orderKey of
+    // everything selected, flipped by add/remove and by rollback
+    uint64_t aisleHash = 0, orderHash = 0;
+
+    // Dynamic layer over c.aisleToOrders: units of still unselected orders
+    // each aisle can supply. Kept current by addOrder/removeOrder. Only an
+    // optimistic bound: it ignores the balance, the aisles already open and
+    // ub. gainOfAisle() clips it with itemNeed.
+    vector<ll> aisleGainBound;
+
+    // Demand of every order for each item minus the stock of the open
+    // aisles: what one more aisle can still be useful for. Order moves shift
+    // demand and balance alike and leave it alone; kept by addAisle/removeAisle.
+    vector<ll> itemNeed;
+
+    // Scratch space for screenOrders: short lines of one order
+    vector<int32_t> screenLines;
+
+    // Scratch space for the *TouchedSince queries: marks and item list
+    vector<char> touchedItem, touchedOrder, touchedAisle;
+    vector<int> touchedItems;
+
+    // Scratch space for addAislesToRepairSolution: {coverage bound, aisle}
+    vector<pair<ll, int>> repairHeap;
+    vector<char> repairSeen;
+
+    // UNDO JOURNAL
+    // While a checkpoint is open, every balance, deficit-set, unit and
+    // selection change is logged with its previous value, so rollback() is
+    // O(changes) and recomputes nothing. Checkpoints nest, and must close
+    // innermost first.
+    enum class JournalOp : uint8_t { Balance, DeficitInserted, DeficitErased, Units, Aisle, Order };
+    struct JournalEntry {
+        JournalOp op;
+        int index;
+        ll value;
+    };
+    vector<JournalEntry> journal;
+    vector<size_t> openMarks; // Marks of the open checkpoints, innermost last
+
+    State(const Problem &prob, const Caches<L> &caches, Solution &sol)
         : p(prob), c(caches), currentTotalUnits(0), aisleSolution(sol.mAisles), orderSolution(sol.mOrders)
     {
         reset();
     }
 
     void reset() {
+        journal.clear();
+        openMarks.clear();
         currentTotalUnits = 0;
         deficitItems.clear();
+        aisleHash = orderHash = 0;
 
         itemBalance.clear();
         itemBalance.resize(p.itemCount + 1, 0);
@@ -120,6 +437,11 @@ struct State {
         orderSelected.clear();
         orderSelected.resize(p.orders.size(), false);
 
+        aisleGainBound = c.aisleAffinityUnits;
+        itemNeed.assign(p.itemCount + 1, 0);
+        for (size_t item = 0; item < c.itemToOrders.size(); item += 1)
+            for (const auto &posting : c.itemToOrders[item]) itemNeed[item] += posting.first;
+
         vector<int> buffer;
         buffer.assign(aisleSolution.begin(), aisleSolution.end());
         aisleSolution.clear();
@@ -133,21 +455,26 @@ struct State {
     // O(Number of items in the aisle)
     void addAisle(int aisleIdx) {
         if (aisleSelected[aisleIdx]) return;
+        record(JournalOp::Aisle, aisleIdx);
         aisleSelected[aisleIdx] = true;
         aisleSolution.insert(aisleIdx);
+        aisleHash ^= Dedup::aisleKey(aisleIdx);
 
         for (const auto& line : p.aisles[aisleIdx]) {
             int item = line.ff;
             int qty = line.ss;
+            itemNeed[item] -= qty;
             
             // Before update: was it in deficit?
             bool wasDeficit = (itemBalance[item] < 0);
             
+            record(JournalOp::Balance, item, itemBalance[item]);
             itemBalance[item] += qty;
             
             // After update: is it solved?
             if (wasDeficit && itemBalance[item] >= 0) {
                 deficitItems.erase(item);
+                record(JournalOp::DeficitErased, item);
             }
         }
     }
@@ -155,19 +482,24 @@ struct State {
     // O(Number of items in the aisle)
     void removeAisle(int aisleIdx) {
         if (!aisleSelected[aisleIdx]) return;
+        record(JournalOp::Aisle, aisleIdx);
         aisleSelected[aisleIdx] = false;
         aisleSolution.erase(aisleIdx);
+        aisleHash ^= Dedup::aisleKey(aisleIdx);
 
         for (const auto& line : p.aisles[aisleIdx]) {
             int item = line.ff;
             int qty = line.ss;
+            itemNeed[item] += qty;
 
             bool wasOK = (itemBalance[item] >= 0);
             
+            record(JournalOp::Balance, item, itemBalance[item]);
             itemBalance[item] -= qty;
             
             if (wasOK && itemBalance[item] < 0) {
                 deficitItems.insert(item);
+                record(JournalOp::DeficitInserted, item);
             }
         }
     }
@@ -175,9 +507,14 @@ struct State {
     // O(Number of items in the order)
     void addOrder(int orderIdx) {
         if (orderSelected[orderIdx]) return;
+        record(JournalOp::Order, orderIdx);
+        record(JournalOp::Units, 0, currentTotalUnits);
         orderSelected[orderIdx] = true;
         orderSolution.insert(orderIdx);
+        orderHash ^= Dedup::orderKey(orderIdx);
         currentTotalUnits += c.orderTotalUnits[orderIdx];
+        for (const auto& posting : c.orderToAisles[orderIdx])
+            aisleGainBound[posting.second] -= posting.first;
 
         for (const auto& line : p.orders[orderIdx]) {
             int item = line.ff;
@@ -185,10 +522,12 @@ struct State {
 
             bool wasOK = (itemBalance[item] >= 0);
             
+            record(JournalOp::Balance, item, itemBalance[item]);
             itemBalance[item] -= qty; // Requirement reduces balance
             
             if (wasOK && itemBalance[item] < 0) {
                 deficitItems.insert(item);
+                record(JournalOp::DeficitInserted, item);
             }
         }
     }
@@ -196,9 +535,14 @@ struct State {
     // O(Number of items in the order)
     void removeOrder(int orderIdx) {
         if (!orderSelected[orderIdx]) return;
+        record(JournalOp::Order, orderIdx);
+        record(JournalOp::Units, 0, currentTotalUnits);
         orderSelected[orderIdx] = false;
         orderSolution.erase(orderIdx);
+        orderHash ^= Dedup::orderKey(orderIdx);
         currentTotalUnits -= c.orderTotalUnits[orderIdx];
+        for (const auto& posting : c.orderToAisles[orderIdx])
+            aisleGainBound[posting.second] += posting.first;
 
         for (const auto& line : p.orders[orderIdx]) {
             int item = line.ff;
@@ -206,12 +550,78 @@ struct State {
             
             bool wasDeficit = (itemBalance[item] < 0);
             
+            record(JournalOp::Balance, item, itemBalance[item]);
             itemBalance[item] += qty; // Removing requirement increases balance
             
             if (wasDeficit && itemBalance[item] >= 0) {
                 deficitItems.erase(item);
+                record(JournalOp::DeficitErased, item);
+            }
+        }
+    }
+
+    void record(JournalOp op, int index, ll value = 0) {
+        if (!openMarks.empty()) journal.push_back({op, index, value});
+    }
+
+    // Opens a (possibly nested) checkpoint; pass the mark to rollback() or commit()
+    size_t checkpoint() {
+        openMarks.push_back(journal.size());
+        return journal.size();
+    }
+
+    // Closes the innermost checkpoint, which must be the one `mark` came from
+    void close(size_t mark) {
+        assert(!openMarks.empty() && openMarks.back() == mark && mark <= journal.size());
+        openMarks.pop_back();
+        if (openMarks.empty()) journal.clear();
+    }
+
+    // Keeps the changes since `mark`. An enclosing checkpoint can still undo them.
+    void commit(size_t mark) {
+        close(mark);
+    }
+
+    // Undoes every change since `mark`, newest first
+    void rollback(size_t mark) {
+        assert(!openMarks.empty() && openMarks.back() == mark && mark <= journal.size());
+        while (journal.size() > mark) {
+            JournalEntry e = journal.back();
+            journal.pop_back();
+            switch (e.op) {
+                case JournalOp::Balance:
+                    itemBalance[e.index] = (balance_t)e.value;
+                    break;
+                case JournalOp::DeficitInserted:
+                    deficitItems.erase(e.index);
+                    break;
+                case JournalOp::DeficitErased:
+                    deficitItems.insert(e.index);
+                    break;
+                case JournalOp::Units:
+                    currentTotalUnits = e.value;
+                    break;
+                case JournalOp::Aisle:
+                    aisleSelected[e.index] = !aisleSelected[e.index];
+                    aisleHash ^= Dedup::aisleKey(e.index);
+                    if (aisleSelected[e.index]) aisleSolution.insert(e.index);
+                    else aisleSolution.erase(e.index);
+                    for (const auto& line : p.aisles[e.index])
+                        itemNeed[line.ff] += aisleSelected[e.index] ? -line.ss : line.ss;
+                    break;
+                case JournalOp::Order: {
+                    orderSelected[e.index] = !orderSelected[e.index];
+                    orderHash ^= Dedup::orderKey(e.index);
+                    ll sign = orderSelected[e.index] ? -1 : 1;
+                    if (orderSelected[e.index]) orderSolution.insert(e.index);
+                    else orderSolution.erase(e.index);
+                    for (const auto& posting : c.orderToAisles[e.index])
+                        aisleGainBound[posting.second] += sign * posting.first;
+                    break;
+                }
             }
         }
+        close(mark);
     }
 
     // Fast feasibility check
@@ -221,8 +631,67 @@ struct State {
                currentTotalUnits <= p.ub;
     }
 
+    // DELTAS, in the order given with Caches. No checkpoint may be open; the
+    // state is patched for the affected items only and may be left short
+    // (repair with drop/addAislesToRepairSolution) or past the new bounds.
+
+    // After Caches::updateAisleStock
+    void aisleStockChanged(int aisleIdx, int item, int oldQty, int newQty) {
+        if (aisleSelected[aisleIdx]) {
+            bool wasDeficit = itemBalance[item] < 0;
+            itemBalance[item] += newQty - oldQty;
+            if (wasDeficit && itemBalance[item] >= 0) deficitItems.erase(item);
+            if (!wasDeficit && itemBalance[item] < 0) deficitItems.insert(item);
+            itemNeed[item] -= newQty - oldQty;
+        }
+        aisleGainBound[aisleIdx] = 0;
+        for (const auto &posting : c.aisleToOrders[aisleIdx])
+            if (!orderSelected[posting.second]) aisleGainBound[aisleIdx] += posting.first;
+    }
+
+    // After Caches::addOrder
+    void orderAdded(int orderIdx) {
+        orderSelected.resize(orderIdx + 1, false);
+        for (const auto &posting : c.orderToAisles[orderIdx])
+            aisleGainBound[posting.second] += posting.first;
+        for (const auto &line : p.orders[orderIdx]) itemNeed[line.ff] += line.ss;
+    }
+
+    // Before Caches::removeOrder
+    void orderRemoving(int orderIdx) {
+        removeOrder(orderIdx);
+        for (const auto &posting : c.orderToAisles[orderIdx])
+            aisleGainBound[posting.second] -= posting.first;
+        for (const auto &line : p.orders[orderIdx]) itemNeed[line.ff] -= line.ss;
+    }
+
+    Certificate certify() const {
+        return {currentTotalUnits, aisleSolution.size(), isFeasible()};
+    }
+
     double calculateScore() const {
-        return (double)currentTotalUnits / aisleSelected.size();
+        if (aisleSolution.empty()) return 0.0;
+        return (double)currentTotalUnits / aisleSolution.size();
+    }
+
+    // O(1), 0 once selected: aisleGainBound, cheap enough to keep sampler weights current
+    ll gainBoundOfAisle(int aisleIdx) const {
+        return aisleSelected[aisleIdx] ? 0 : aisleGainBound[aisleIdx];
+    }
+
+    // O(items in the aisle), 0 once selected: the deficit units it would
+    // cover, plus the units of unselected orders it could help supply, capped
+    // by aisleGainBound, by the stock it has beyond the open aisles' and by
+    // the room left under ub
+    ll gainOfAisle(int aisleIdx) const {
+        if (aisleSelected[aisleIdx]) return 0;
+        ll cover = 0, useful = 0;
+        for (const auto& line : p.aisles[aisleIdx]) {
+            balance_t balance = itemBalance[line.ff];
+            if (balance < 0) cover += min<ll>(line.ss, -(ll)balance);
+            if (itemNeed[line.ff] > 0) useful += min<ll>(line.ss, itemNeed[line.ff]);
+        }
+        return cover + max<ll>(0, min({aisleGainBound[aisleIdx], useful - cover, p.ub - currentTotalUnits}));
     }
 
     // Fast check if a specific order CAN fit into current aisle selection
@@ -242,6 +711,109 @@ struct State {
         return true;
     }
 
+    // Batched canFitOrder over every order: one branchless pass over the flat
+    // lines. fits[o] says whether unselected order o fits without new aisles.
+    // When asked, newAisles[o] counts its lines that would fall short where
+    // the item's best aisle is not open yet, the constructions' estimate of
+    // the aisles it would cost. Returns how many fit.
+    size_t screenAllOrders(vector<uint8_t> &fits, vector<int> *newAisles = nullptr) {
+        int lines = c.orderLineStart.back();
+        screenLines.resize(lines + Screen::PADDING);
+        int lacking = Screen::shortLines(itemBalance.data(), c.orderLineItem.data(), c.orderLineQty.data(),
+                                         lines, screenLines.data());
+
+        // Found lines come out in order, so these writes walk forward
+        fits.assign(p.orders.size(), 1);
+        for (int k = 0; k < lacking; k += 1) fits[c.orderLineOwner[screenLines[k]]] = 0;
+        if (newAisles) {
+            newAisles->assign(p.orders.size(), 0);
+            for (int k = 0; k < lacking; k += 1) {
+                int line = screenLines[k], top = c.itemTopAisle[c.orderLineItem[line]];
+                (*newAisles)[c.orderLineOwner[line]] += top == -1 || !aisleSelected[top];
+            }
+        }
+
+        size_t fitting = 0;
+        ll room = p.ub - currentTotalUnits;
+        for (size_t o = 0; o < p.orders.size(); o += 1) {
+            fits[o] &= (c.orderTotalUnits[o] <= room);
+            fitting += fits[o];
+        }
+        for (int o : orderSolution) fitting -= fits[o], fits[o] = 0;
+        return fitting;
+    }
+
+    // Same screening for a few scattered candidates, one order at a time
+    size_t screenOrders(const int *orders, size_t count, vector<uint8_t> &fits, vector<int> &newAisles) {
+        fits.resize(count);
+        newAisles.resize(count);
+        size_t fitting = 0;
+        for (size_t i = 0; i < count; i += 1) {
+            int o = orders[i];
+            uint32_t start = c.orderLineStart[o];
+            int lines = c.orderLineStart[o + 1] - start;
+            if (screenLines.size() < (size_t)lines + Screen::PADDING) screenLines.resize(lines + Screen::PADDING);
+
+            int lacking = Screen::shortLinesScalar(itemBalance.data(), c.orderLineItem.data() + start,
+                                                   c.orderLineQty.data() + start, lines, screenLines.data());
+            int estimate = 0;
+            for (int k = 0; k < lacking; k += 1) {
+                int top = c.itemTopAisle[c.orderLineItem[start + screenLines[k]]];
+                estimate += top == -1 || !aisleSelected[top];
+            }
+
+            fits[i] = lacking == 0 && currentTotalUnits + c.orderTotalUnits[o] <= p.ub;
+            newAisles[i] = estimate;
+            fitting += fits[i];
+        }
+        return fitting;
+    }
+
+    // Unselected orders sharing an item whose balance changed since `mark`
+    // (a checkpoint must still be open), each once. These are the orders
+    // whose screenOrders result can differ from before the mark.
+    void ordersTouchedSince(size_t mark, vector<int> &orders) {
+        touchedItem.resize(p.itemCount + 1, 0);
+        touchedOrder.resize(p.orders.size(), 0);
+        touchedItems.clear();
+        for (size_t k = mark; k < journal.size(); k += 1) {
+            const JournalEntry &e = journal[k];
+            if (e.op != JournalOp::Balance || touchedItem[e.index]) continue;
+            touchedItem[e.index] = 1;
+            touchedItems.push_back(e.index);
+        }
+
+        orders.clear();
+        for (int item : touchedItems) {
+            touchedItem[item] = 0;
+            for (const auto &posting : c.itemToOrders[item]) {
+                int orderIdx = posting.second;
+                if (touchedOrder[orderIdx] || orderSelected[orderIdx]) continue;
+                touchedOrder[orderIdx] = 1;
+                orders.push_back(orderIdx);
+            }
+        }
+        for (int orderIdx : orders) touchedOrder[orderIdx] = 0;
+    }
+
+    // Aisles whose selection or gainBoundOfAisle changed since `mark`, each once
+    void aislesTouchedSince(size_t mark, vector<int> &aisles) {
+        touchedAisle.resize(p.aisles.size(), 0);
+        aisles.clear();
+        auto touch = [&](int aisleIdx) {
+            if (touchedAisle[aisleIdx]) return;
+            touchedAisle[aisleIdx] = 1;
+            aisles.push_back(aisleIdx);
+        };
+        for (size_t k = mark; k < journal.size(); k += 1) {
+            const JournalEntry &e = journal[k];
+            if (e.op == JournalOp::Aisle) touch(e.index);
+            else if (e.op == JournalOp::Order)
+                for (const auto &posting : c.orderToAisles[e.index]) touch(posting.second);
+        }
+        for (int aisleIdx : aisles) touchedAisle[aisleIdx] = 0;
+    }
+
     // Helper: Prune redundant aisles
     vector<int> pruneAislesToFitOrders() {
         vector<int> mem, scanning;
@@ -264,101 +836,100 @@ struct State {
         return mem;
     }
 
+    // Deficit units an unselected aisle would cover right now
+    ll deficitCoverage(int aisleIdx) const {
+        ll cover = 0;
+        for (const auto& line : p.aisles[aisleIdx]) {
+            balance_t balance = itemBalance[line.ff];
+            if (balance < 0) cover += min<ll>(line.ss, -(ll)balance);
+        }
+        return cover;
+    }
+
     // Helper: Greedy Aisle Selection to satisfy deficits in State
-    // Returns the number of new aisles added
+    // Returns the number of new aisles added, or -1 if the deficits can't be covered.
+    //
+    // Lazy greedy (CELF): adding an aisle only shrinks the coverage of the
+    // others, so a heap value is always an upper bound. The top is re-evaluated
+    // when popped and taken if it still beats the next bound; only aisles that
+    // share a deficit item with a chosen one ever see their value change.
     int addAislesToRepairSolution() {
-        int addedCount = 0;
+        if (deficitItems.empty()) return 0;
+
+        repairHeap.clear();
+        repairSeen.resize(p.aisles.size(), 0);
+        for (auto i : deficitItems) {
+            for (const auto& pair : c.itemToAisles[i]) {
+                int aisleIdx = pair.second;
+                if (aisleSelected[aisleIdx] || repairSeen[aisleIdx]) continue;
+                repairSeen[aisleIdx] = 1;
+                repairHeap.push_back({deficitCoverage(aisleIdx), aisleIdx});
+            }
+        }
+        for (const auto& entry : repairHeap) repairSeen[entry.second] = 0;
+        make_heap(repairHeap.begin(), repairHeap.end());
 
+        int addedCount = 0;
         while (!deficitItems.empty()) {
-            int bestAisle = -1;
-            ll bestCover = -1;
-
-            // Optimization: Instead of scanning ALL aisles, we only look at aisles
-            // that contain the items we currently need.
-            // We collect candidate aisles from the inverse index of items in deficit.
-            
-            // To avoid iterating all items, we can maintain a set of "deficit items" in State, 
-            // but for now, iterating items is O(I). If I is large, this loop is the bottleneck.
-            // Heuristic optimization: Just look at the first few items in deficit.
-            
-            // Collect candidates
-            // Map: aisle_index -> quantity_of_deficit_covered
-            unordered_map<int, ll> aisleScores;
-
-            for (auto i: deficitItems) {
-                ll needed = -itemBalance[i]; // Positive magnitude of need
-                
-                // Look at the best aisles for this item from Cache
-                // We only look at top X aisles to keep it fast
-                int checks = 0;
-                for(const auto& pair : c.itemToAisles[i]) {
-                    int qty = pair.first;
-                    int aisleIdx = pair.second;
-                    
-                    // Skip if already selected
-                    if (aisleSelected[aisleIdx]) continue;
-
-                    ll useful = min((ll)qty, needed);
-                    aisleScores[aisleIdx] += useful;
-
-                    checks++;
-                    if (checks > 5) break; // Optimization: only check top 5 providers per item
-                }
-            }
+            if (repairHeap.empty()) return -1; // Impossible to satisfy
 
-            if (aisleScores.empty()) return -1; // Impossible to satisfy
+            pop_heap(repairHeap.begin(), repairHeap.end());
+            int aisleIdx = repairHeap.back().second;
+            repairHeap.pop_back();
 
-            // Pick best
-            for (auto const& [aisle, score] : aisleScores) {
-                if (score > bestCover) {
-                    bestCover = score;
-                    bestAisle = aisle;
-                }
-            }
+            ll cover = deficitCoverage(aisleIdx);
+            if (cover <= 0) continue;
 
-            if (bestAisle != -1) {
-                addAisle(bestAisle);
+            if (repairHeap.empty() || cover >= repairHeap.front().first) {
+                addAisle(aisleIdx);
                 addedCount++;
             } else {
-                return -1; // Should not happen if global feasibility is checked
+                repairHeap.push_back({cover, aisleIdx});
+                push_heap(repairHeap.begin(), repairHeap.end());
             }
         }
         return addedCount;
     }
 
-    int estimateNewItemsForAisle(int aisleIdx) {
-        int estimatedNewItems = 0;
-        for(const auto &line : p.aisles[aisleIdx]) {
-            int item = line.ff;
-            int qty = line.ss;
-
-            for(const auto &line2 : c.itemToOrders[item]) {
-                int orderQty = line.ff;
-                int orderIdx = line2.ss;
-
-                if (currentTotalUnits + estimatedNewItems + c.orderTotalUnits[orderIdx] > p.ub) {
-                    continue;
-                }
-
-                if(itemBalance[item] + qty >= orderQty) {
-                    estimatedNewItems += orderQty;
-                    qty -= orderQty;
-                }
+    // Drops selected orders that draw on a short item until nothing is
+    // short. Returns how many were removed.
+    int dropOrdersToRepairSolution() {
+        int removed = 0;
+        vector<size_t> shortItems(deficitItems.begin(), deficitItems.end());
+        for (size_t item : shortItems) {
+            for (const auto &posting : c.itemToOrders[item]) {
+                if (itemBalance[item] >= 0) break;
+                if (!orderSelected[posting.second]) continue;
+                removeOrder(posting.second);
+                removed += 1;
             }
         }
-        return estimatedNewItems;
+        return removed;
+    }
+
+    // Orders served by an aisle that fit without new aisles, biggest first
+    void packOrdersFromAisle(int aisleIdx) {
+        vector<int> candidates;
+        for (const auto &posting : c.aisleToOrders[aisleIdx])
+            if (!orderSelected[posting.second]) candidates.push_back(posting.second);
+        std::sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+            return c.orderTotalUnits[a] > c.orderTotalUnits[b];
+        });
+        for (int o : candidates) {
+            if (canFitOrder(o)) addOrder(o);
+        }
     }
 
-    void addAisleWithOrdersGreedy(int aisleIdx) {
+    // Opens the aisle and fills every order it now makes fit.
+    // Orders added are appended to `added` when given, so callers can undo the move.
+    void addAisleWithOrdersGreedy(int aisleIdx, vector<int> *added = nullptr) {
         addAisle(aisleIdx);
-        for(const auto &line : p.aisles[aisleIdx]) {
-            int item = line.ff;
-            for(const auto &line2 : c.itemToOrders[item]) {
-                int orderIdx = line2.ss;
-                if (orderSelected[orderIdx]) continue;
-                if (canFitOrder(orderIdx)) {
-                    addOrder(orderIdx);
-                }
+        for(const auto &posting : c.aisleToOrders[aisleIdx]) {
+            int orderIdx = posting.second;
+            if (orderSelected[orderIdx]) continue;
+            if (canFitOrder(orderIdx)) {
+                addOrder(orderIdx);
+                if (added) added->push_back(orderIdx);
             }
         }
     }
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "common.hpp"
+
+/**
+ * NATIVE CHECKER
+ * Validates a wave against the instance with flat per-item arrays, one pass
+ * over the selected orders and aisles. Same rules as checker.py, but it
+ * reports why a wave fails instead of just "False".
+ */
+namespace Checker {
+    // A solution file as written, duplicates and bad ids included
+    struct RawSolution {
+        vector<ll> orders, aisles;
+        bool complete = false; // Both counts were present and fully read
+    };
+
+    struct ItemSlack {
+        int item;
+        ll required, available;
+    };
+
+    struct Report {
+        bool feasible = false;
+        double objective = 0.0;
+        ll units = 0;
+        size_t orders = 0, aisles = 0;
+        vector<std::string> violations;
+        vector<ItemSlack> items; // Every item the wave requires, in id order
+    };
+
+    RawSolution readSolution(FastReader &input) {
+        RawSolution s;
+        ll count;
+        if (!input.next(count)) return s;
+        for (ll i = 0; i < count; i += 1) {
+            ll o;
+            if (!input.next(o)) return s;
+            s.orders.pb(o);
+        }
+        if (!input.next(count)) return s;
+        for (ll i = 0; i < count; i += 1) {
+            ll a;
+            if (!input.next(a)) return s;
+            s.aisles.pb(a);
+        }
+        s.complete = true;
+        return s;
+    }
+
+    bool readSolutionFile(const std::string &path, RawSolution &s) {
+        bool ok;
+        FastReader reader(path, ok);
+        if (ok) s = readSolution(reader);
+        return ok;
+    }
+
+    Report check(const Problem &p, const RawSolution &s) {
+        Report r;
+        if (!s.complete) r.violations.pb("truncated solution file");
+
+        vector<char> orderSeen(p.orders.size(), 0), aisleSeen(p.aisles.size(), 0);
+        vector<ll> required(p.itemCount + 1, 0), available(p.itemCount + 1, 0);
+        vector<char> itemSeen(p.itemCount + 1, 0);
+        vector<int> touched;
+
+        for (ll o : s.orders) {
+            if (o < 0 || o >= (ll)p.orders.size()) {
+                r.violations.pb("order " + std::to_string(o) + " out of range");
+                continue;
+            }
+            if (orderSeen[o]) {
+                r.violations.pb("order " + std::to_string(o) + " repeated");
+                continue;
+            }
+            orderSeen[o] = 1;
+            r.orders += 1;
+            for (const auto &line : p.orders[o]) {
+                if (!itemSeen[line.ff]) { itemSeen[line.ff] = 1; touched.pb(line.ff); }
+                required[line.ff] += line.ss;
+                r.units += line.ss;
+            }
+        }
+
+        for (ll a : s.aisles) {
+            if (a < 0 || a >= (ll)p.aisles.size()) {
+                r.violations.pb("aisle " + std::to_string(a) + " out of range");
+                continue;
+            }
+            if (aisleSeen[a]) {
+                r.violations.pb("aisle " + std::to_string(a) + " repeated");
+                continue;
+            }
+            aisleSeen[a] = 1;
+            r.aisles += 1;
+            for (const auto &line : p.aisles[a])
+                available[line.ff] += line.ss;
+        }
+
+        if (r.units < p.lb || r.units > p.ub)
+            r.violations.pb("wave has " + std::to_string(r.units) + " units, bounds are ["
+                + std::to_string(p.lb) + ", " + std::to_string(p.ub) + "]");
+
+        std::sort(all(touched));
+        r.items.reserve(touched.size());
+        for (int item : touched) {
+            r.items.pb({item, required[item], available[item]});
+            if (required[item] > available[item])
+                r.violations.pb("item " + std::to_string(item) + " short by "
+                    + std::to_string(required[item] - available[item]));
+        }
+
+        r.feasible = r.violations.empty();
+        r.objective = r.aisles == 0 ? 0.0 : (double)r.units / r.aisles;
+        return r;
+    }
+
+    Report check(const Problem &p, const Solution &solution) {
+        RawSolution s;
+        s.orders.assign(all(solution.mOrders));
+        s.aisles.assign(all(solution.mAisles));
+        s.complete = true;
+        return check(p, s);
+    }
+}
@@ -101,10 +101,14 @@
 #include <map>
 #include <unordered_set>
 #include <set>
+#include <bitset>
 #include <chrono>
 #include <iostream>
 #include <random>
 #include <thread>
+#include <cstdio>
+#include <sstream>
+#include <atomic>
 
 using namespace std;
 
@@ -119,6 +123,80 @@ typedef long long ll;
 const int INF = 0x3f3f3f3f;
 const ll LINF = 0x3f3f3f3f3f3f3f3fll;
 
+/**
+ * SEEDS
+ * Every random generator in the solver is seeded from here. With a base
+ * seed (--seed) the generators get base, base + 1, ... in the order they
+ * ask, so a single-threaded run repeats its choices; with 0 they are seeded
+ * from random_device. Runs still stop on wall-clock patience, so only the
+ * choices repeat, not the number of restarts.
+ */
+namespace Seed {
+    inline std::atomic<unsigned> base{0}, drawn{0};
+
+    inline unsigned next() {
+        unsigned b = base.load();
+        if (b == 0) return std::random_device{}();
+        return b + drawn++;
+    }
+}
+
+// splitmix64 finalizer: the one bit mixer behind the MinHash signatures
+// and the Zobrist keys of the duplicate cache
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * FAST READER
+ * Slurps the whole input and parses non-negative integers by hand.
+ * `input >> x` dominates load time on the 40-68k order instances.
+ */
+struct FastReader {
+    std::string buffer;
+    size_t pos = 0;
+    bool truncated = false; // Some nextOr ran out of input and took the fallback
+
+    FastReader(std::istream &input) {
+        std::ostringstream ss;
+        ss << input.rdbuf();
+        buffer = ss.str();
+    }
+
+    FastReader(const std::string &path, bool &ok) {
+        FILE *f = fopen(path.c_str(), "rb");
+        ok = (f != nullptr);
+        if (!ok) return;
+        char chunk[1 << 16];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buffer.append(chunk, n);
+        fclose(f);
+    }
+
+    // Returns false at end of input
+    bool next(ll &value) {
+        while (pos < buffer.size() && (buffer[pos] < '0' || buffer[pos] > '9') && buffer[pos] != '-') pos++;
+        if (pos >= buffer.size()) return false;
+        bool negative = buffer[pos] == '-';
+        if (negative) pos++;
+        value = 0;
+        while (pos < buffer.size() && buffer[pos] >= '0' && buffer[pos] <= '9')
+            value = value * 10 + (buffer[pos++] - '0');
+        if (negative) value = -value;
+        return true;
+    }
+
+    ll nextOr(ll fallback) {
+        ll value;
+        if (next(value)) return value;
+        truncated = true;
+        return fallback;
+    }
+};
+
 struct Problem {
     // A vector of (item, quantity) pairs for each order / aisle.
     vector<vector<pair<int, int>>> orders, aisles;
@@ -126,25 +204,66 @@ struct Problem {
 
     Problem() {}
 
+    // DELTAS (see Caches for the matching updates). Ids never move: a
+    // cleared order stays as an empty one, and item ids must already exist.
+
+    // Sets the stock of an item in an aisle, 0 removes the line. Returns the old quantity.
+    int setAisleStock(int aisle, int item, int qty) {
+        auto &lines = aisles[aisle];
+        int old = 0;
+        for (size_t i = 0; i < lines.size(); i += 1) {
+            if (lines[i].ff != item) continue;
+            old = lines[i].ss;
+            lines.erase(lines.begin() + i);
+            break;
+        }
+        if (qty > 0) {
+            auto at = std::find_if(lines.begin(), lines.end(), [&](auto &line) { return line.ss < qty; });
+            lines.insert(at, {item, qty});
+        }
+        return old;
+    }
+
+    int addOrder(vector<pair<int, int>> lines) {
+        std::sort(lines.begin(), lines.end(), [](auto &a, auto &b) { return a.ss > b.ss; });
+        orders.pb(std::move(lines));
+        return orders.size() - 1;
+    }
+
+    void clearOrder(int order) { orders[order].clear(); }
+
+    void setBounds(ll lower, ll upper) {
+        lb = lower;
+        ub = upper;
+    }
+
     void readFrom(std::istream &input) {
-        ll orderCount, aisleCount;
-        input >> orderCount >> itemCount >> aisleCount;
+        FastReader reader(input);
+        readFrom(reader);
+    }
+
+    void readFrom(FastReader &input) {
+        ll orderCount = input.nextOr(0), aisleCount;
+        itemCount = input.nextOr(0);
+        aisleCount = input.nextOr(0);
 
         orders.resize(orderCount);
         aisles.resize(aisleCount);
 
         for(int j = 0; j < orderCount; j++){
-            int k; input >> k;
+            int k = input.nextOr(0);
+            orders[j].reserve(k);
             for(int l = 0; l < k; l++){
-                int iten, quant; input >> iten >> quant;
+                int iten = input.nextOr(0), quant = input.nextOr(0);
                 orders[j].pb({iten, quant});
             }
         }
 
         for(int j = 0; j < aisleCount; j++){
-            int l; input >> l;
+            int l = input.nextOr(0);
+            aisles[j].reserve(l);
             for(int t = 0; t < l; t++){
-                int iten, quant; input >> iten >> quant;
+                int iten = input.nextOr(0), quant = input.nextOr(0);
                 aisles[j].pb({iten, quant});
             }
         }
@@ -155,7 +274,8 @@ struct Problem {
         for(auto &order: orders)
             std::sort(order.begin(), order.end(), [](auto &a, auto &b) { return a.ss > b.ss; });
 
-        input >> lb >> ub;
+        lb = input.nextOr(0);
+        ub = input.nextOr(0);
     }
 
     static Problem ReadFrom(std::istream &input) {
@@ -163,19 +283,40 @@ struct Problem {
         p.readFrom(input);
         return p;
     }
+
+    // False when the file cannot be opened or ends before lb and ub
+    static bool ReadFromFile(const std::string &path, Problem &p) {
+        bool ok;
+        FastReader reader(path, ok);
+        if (ok) p.readFrom(reader);
+        return ok && !reader.truncated;
+    }
+};
+
+// What a heuristic vouches for about the solution it built, straight from
+// its incremental state. The driver trusts it and runs the full check only
+// on a new best (or on every run with Config::verify).
+struct Certificate {
+    ll units = 0;
+    size_t aisles = 0;
+    bool feasible = false;
+
+    double score() const {
+        return aisles == 0 ? 0.0 : (double)units / aisles;
+    }
 };
 
 struct Solution {
     std::unordered_set<int> mOrders, mAisles;
 
-    void print(){
-        cout << mOrders.size() << endl;
+    void print(std::ostream &out = cout) const {
+        out << mOrders.size() << endl;
         for(int o: mOrders)
-            cout << o << endl;
+            out << o << endl;
 
-        cout << mAisles.size() << endl;
+        out << mAisles.size() << endl;
         for(int a: mAisles)
-            cout << a << endl;
+            out << a << endl;
     }
     
     int getTotalUnits(const Problem &p) const {
@@ -200,6 +341,11 @@ struct Solution {
         return log(totalUnits) - log(mAisles.size());
     }
 
+    // Full recount, for heuristics that keep no incremental state
+    Certificate certify(const Problem &p) const {
+        return {getTotalUnits(p), mAisles.size(), checkFeasibility(p)};
+    }
+
     bool checkFeasibility(const Problem &p) const {
         std::unordered_set<int> seen;
         for (int orderIdx : mOrders) {
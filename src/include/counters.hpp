@@ -0,0 +1,95 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * PERF COUNTERS
+ * Hardware counters for the whole process (threads started after begin()
+ * included), read with perf_event_open. Used to compare the cache behaviour
+ * of the solver with and without relabeling. Counters the kernel or the
+ * machine does not expose read as -1.
+ */
+namespace Perf {
+    struct Counters {
+        ll cacheMisses = -1, cacheReferences = -1, instructions = -1, cycles = -1;
+    };
+
+    class Session {
+#ifdef __linux__
+        std::vector<int> fds;
+
+        static int open(uint32_t type, uint64_t config) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        static ll read(int fd) {
+            if (fd < 0) return -1;
+            uint64_t value = 0;
+            if (::read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+            return (ll)value;
+        }
+#endif
+
+    public:
+        void begin() {
+#ifdef __linux__
+            fds = {
+                open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+                open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES),
+                open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+                open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+            };
+            for (int fd : fds) {
+                if (fd < 0) continue;
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        Counters end() {
+            Counters counters;
+#ifdef __linux__
+            for (int fd : fds)
+                if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (fds.size() == 4) {
+                counters.cacheMisses = read(fds[0]);
+                counters.cacheReferences = read(fds[1]);
+                counters.instructions = read(fds[2]);
+                counters.cycles = read(fds[3]);
+            }
+            for (int fd : fds)
+                if (fd >= 0) close(fd);
+            fds.clear();
+#endif
+            return counters;
+        }
+    };
+
+    void report(std::ostream &out, const Counters &c) {
+        if (c.cacheMisses < 0 && c.instructions < 0) {
+            out << "Perf counters unavailable" << std::endl;
+            return;
+        }
+        out << "Perf: " << c.cacheMisses << " cache misses / " << c.cacheReferences << " references";
+        if (c.cacheReferences > 0) out << " (" << 100.0 * c.cacheMisses / c.cacheReferences << "%)";
+        out << ", " << c.instructions << " instructions, " << c.cycles << " cycles" << std::endl;
+    }
+}
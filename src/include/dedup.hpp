@@ -0,0 +1,59 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <atomic>
+#include <memory>
+
+/**
+ * DUPLICATE-SOLUTION CACHE
+ * Zobrist keys for aisles and orders (a fixed hash of the index, so every
+ * thread and every State agree on them without a table), and a fixed-size
+ * lossy set of the aisle-set hashes already refined. Threads share the set
+ * without locks: slots are atomics in 4-way buckets, and a full bucket
+ * overwrites a slot picked by the key. A lost entry only costs a repeated
+ * refinement; a race on the same key lets both threads through.
+ */
+namespace Dedup {
+    inline uint64_t aisleKey(int aisle) { return mix64(2 * (uint64_t)aisle); }
+    inline uint64_t orderKey(int order) { return mix64(2 * (uint64_t)order + 1); }
+
+    class Table {
+        static constexpr size_t WAYS = 4;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+        size_t buckets;
+        std::atomic<size_t> claims{0}, repeats{0};
+
+    public:
+        // `capacity` slots, rounded up to a power of two
+        explicit Table(size_t capacity) {
+            buckets = 1;
+            while (buckets * WAYS < capacity) buckets *= 2;
+            slots = std::make_unique<std::atomic<uint64_t>[]>(buckets * WAYS);
+            for (size_t i = 0; i < buckets * WAYS; i += 1) slots[i].store(0, std::memory_order_relaxed);
+        }
+
+        // True the first time `hash` is claimed (as far as the table still
+        // remembers), false when some thread has already claimed it
+        bool claim(uint64_t hash) {
+            uint64_t key = hash | 1; // 0 marks an empty slot
+            std::atomic<uint64_t> *bucket = &slots[(key >> 8 & (buckets - 1)) * WAYS];
+            claims.fetch_add(1, std::memory_order_relaxed);
+            for (size_t way = 0; way < WAYS; way += 1) {
+                if (bucket[way].load(std::memory_order_relaxed) == key) {
+                    repeats.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            for (size_t way = 0; way < WAYS; way += 1) {
+                uint64_t empty = 0;
+                if (bucket[way].compare_exchange_strong(empty, key, std::memory_order_relaxed)) return true;
+            }
+            bucket[key >> 62].store(key, std::memory_order_relaxed);
+            return true;
+        }
+
+        size_t claimCount() const { return claims.load(); }
+        size_t repeatCount() const { return repeats.load(); }
+    };
+}
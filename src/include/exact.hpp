@@ -0,0 +1,360 @@
+#pragma once
+
+#include "common.hpp"
+
+/**
+ * EXACT SOLVER FOR SMALL INSTANCES
+ * Branch-and-bound over aisle subsets, aisles taken richest first. Every
+ * subset reached by an "include" is scored with an exact order packing, and
+ * subtrees are cut by a units bound and by dominance between aisles. Meant
+ * for the tiny `a` instances, where it proves the optimum in milliseconds
+ * and the heuristic threads are not needed at all.
+ */
+namespace Exact {
+    const size_t MAX_AISLES = 512;
+    const size_t MAX_ORDERS = 256;
+    const ll MAX_ITEMS = 4096;
+    const ll NODE_LIMIT = 20000000;
+    const chrono::milliseconds TIME_LIMIT = chrono::seconds(1);
+
+    typedef std::bitset<MAX_AISLES> Aisles;
+
+    struct Result {
+        bool optimal = false;
+        Solution solution;
+        ll nodes = 0;
+    };
+
+    bool applicable(const Problem &p) {
+        return p.aisles.size() <= MAX_AISLES && p.orders.size() <= MAX_ORDERS && p.itemCount <= MAX_ITEMS;
+    }
+
+    class BranchAndBound {
+        const Problem &p;
+
+        // Aisles by position, richest first; useless aisles are left out
+        vector<int> aisleAt;
+        vector<ll> useful;
+        vector<Aisles> dominators, dominated, before;
+
+        vector<ll> demand, stock;
+        vector<ll> reachable; // stock of the chosen and undecided aisles
+        ll usefulStock = 0;   // sum over items of min(stock, demand)
+
+        // Every aisle holds at most 1 / weight[i] of the demanded items, so a
+        // wave needs at least the weights of its uncovered items in new aisles
+        vector<double> weight;
+        vector<int> multiplicity;
+        vector<ll> orderUnits;
+        vector<int> byUnits;
+        vector<pair<double, int>> densities;
+        Aisles chosen;
+        int chosenCount = 0;
+
+        vector<int> eligible, packed, bestPacked;
+        vector<ll> capacity;
+        ll packBest = 0;
+
+        double bestScore = 0.0;
+        Result result;
+        bool aborted = false;
+        chrono::high_resolution_clock::time_point deadline;
+
+        bool tick() {
+            result.nodes += 1;
+            if (result.nodes > NODE_LIMIT) aborted = true;
+            if ((result.nodes & 1023) == 0 && chrono::high_resolution_clock::now() > deadline) aborted = true;
+            return !aborted;
+        }
+
+        void addReachable(int aisle, int sign) {
+            for (const auto &line : p.aisles[aisle]) reachable[line.ff] += sign * line.ss;
+        }
+
+        // Ratio bound for the waves with the chosen aisles plus t more taken
+        // from position `from` on, for every t that keeps at least
+        // `minAisles`. Units are capped twice: by the useful stock of the
+        // chosen aisles plus the t richest undecided ones, and from the order
+        // side, where each reachable order brings its units and a share of the
+        // aisles its uncovered items still need; taking orders by density
+        // traces the fractional best for t new aisles.
+        double bound(size_t from, int minAisles) {
+            ll base = 0;
+            densities.clear();
+            for (size_t o = 0; o < p.orders.size(); o += 1) {
+                double cost = 0;
+                bool alive = true;
+                for (const auto &line : p.orders[o]) {
+                    if (reachable[line.ff] < line.ss) { alive = false; break; }
+                    if (stock[line.ff] == 0) cost += weight[line.ff] / multiplicity[line.ff];
+                }
+                if (!alive) continue;
+                if (cost == 0) base += orderUnits[o];
+                else densities.push_back({orderUnits[o] / cost, (int)o});
+            }
+            std::sort(densities.rbegin(), densities.rend());
+
+            double best = 0.0, units = base, cost = 0.0;
+            ll stockCap = usefulStock;
+            size_t next = 0;
+            for (int t = 0; from + t <= useful.size(); t += 1) {
+                if (t > 0) stockCap += useful[from + t - 1];
+                // Fractional orders up to t aisles of cost
+                while (next < densities.size() && units < p.ub) {
+                    double u = orderUnits[densities[next].ss], c = u / densities[next].ff;
+                    if (cost + c > t) {
+                        units += (t - cost) * densities[next].ff;
+                        cost = t;
+                        break;
+                    }
+                    units += u;
+                    cost += c;
+                    next += 1;
+                }
+                int aisles = chosenCount + t;
+                if (aisles < max(1, minAisles)) continue;
+                double cap = min<double>({(double)p.ub, units, (double)stockCap});
+                best = max(best, cap / aisles);
+                if (cap >= p.ub) break;
+                // Past here the stock cap only falls, and so does the order side once it runs out
+                bool stockFalls = from + t == useful.size() || useful[from + t] * aisles <= stockCap;
+                if (stockFalls && ((double)stockCap / aisles <= best || next >= densities.size())) break;
+            }
+            return best;
+        }
+
+        void addStock(int aisle, int sign) {
+            for (const auto &line : p.aisles[aisle]) {
+                ll &s = stock[line.ff];
+                usefulStock -= min(s, demand[line.ff]);
+                s += sign * line.ss;
+                usefulStock += min(s, demand[line.ff]);
+            }
+        }
+
+        // Best packing of the eligible orders from `from` on, within capacity and ub
+        void pack(size_t from, ll units, const vector<ll> &suffix) {
+            if (!tick()) return;
+            if (units > packBest) {
+                packBest = units;
+                bestPacked = packed;
+            }
+            if (from == eligible.size() || units == p.ub) return;
+            if (min<ll>(p.ub, units + suffix[from]) <= packBest) return;
+
+            int o = eligible[from];
+            ll orderUnits = 0;
+            bool fits = true;
+            for (const auto &line : p.orders[o]) {
+                orderUnits += line.ss;
+                if (capacity[line.ff] < line.ss) fits = false;
+            }
+            if (fits && units + orderUnits <= p.ub) {
+                for (const auto &line : p.orders[o]) capacity[line.ff] -= line.ss;
+                packed.push_back(o);
+                pack(from + 1, units + orderUnits, suffix);
+                packed.pop_back();
+                for (const auto &line : p.orders[o]) capacity[line.ff] += line.ss;
+            }
+            pack(from + 1, units, suffix);
+        }
+
+        // Scores the chosen aisles when their stock could beat the incumbent
+        void evaluate() {
+            if (bound(aisleAt.size(), chosenCount) <= bestScore) return;
+
+            eligible.clear();
+            for (size_t o = 0; o < p.orders.size(); o += 1) {
+                bool fits = true;
+                for (const auto &line : p.orders[o]) {
+                    if (stock[line.ff] < line.ss) { fits = false; break; }
+                }
+                if (fits) eligible.push_back(o);
+            }
+            auto unitsOf = [&](int o) {
+                ll units = 0;
+                for (const auto &line : p.orders[o]) units += line.ss;
+                return units;
+            };
+            std::sort(eligible.begin(), eligible.end(), [&](int a, int b) { return unitsOf(a) > unitsOf(b); });
+            vector<ll> suffix(eligible.size() + 1, 0);
+            for (size_t i = eligible.size(); i-- > 0;) suffix[i] = suffix[i + 1] + unitsOf(eligible[i]);
+
+            // Only a packing beating the incumbent (and reaching lb) matters
+            packBest = max<ll>(p.lb - 1, (ll)floor(bestScore * chosenCount + 1e-9));
+            ll target = packBest;
+            capacity = stock;
+            packed.clear();
+            pack(0, 0, suffix);
+
+            if (packBest > target && (double)packBest / chosenCount > bestScore) {
+                bestScore = (double)packBest / chosenCount;
+                result.solution = Solution();
+                result.solution.mOrders.insert(bestPacked.begin(), bestPacked.end());
+                for (size_t i = 0; i < aisleAt.size(); i += 1)
+                    if (chosen[i]) result.solution.mAisles.insert(aisleAt[i]);
+            }
+        }
+
+        // Biggest orders first while they fit; a quick lower bound for seed()
+        ll greedyPack(vector<int> &orders) {
+            capacity = stock;
+            orders.clear();
+            ll units = 0;
+            for (int o : byUnits) {
+                if (units + orderUnits[o] > p.ub) continue;
+                bool fits = true;
+                for (const auto &line : p.orders[o]) {
+                    if (capacity[line.ff] < line.ss) { fits = false; break; }
+                }
+                if (!fits) continue;
+                for (const auto &line : p.orders[o]) capacity[line.ff] -= line.ss;
+                orders.push_back(o);
+                units += orderUnits[o];
+            }
+            return units;
+        }
+
+        // Greedy incumbent before branching: keep opening the aisle whose
+        // greedy packing scores best, so the bounds cut from the first node
+        void seed() {
+            vector<int> orders;
+            int stale = 0;
+            while (chosenCount < (int)aisleAt.size() && stale < 5) {
+                int pick = -1;
+                double pickScore = -1;
+                for (size_t i = 0; i < aisleAt.size(); i += 1) {
+                    if (chosen[i]) continue;
+                    addStock(aisleAt[i], 1);
+                    double score = (double)greedyPack(orders) / (chosenCount + 1);
+                    addStock(aisleAt[i], -1);
+                    if (score > pickScore) { pickScore = score; pick = i; }
+                }
+
+                chosen[pick] = 1;
+                chosenCount += 1;
+                addStock(aisleAt[pick], 1);
+                ll units = greedyPack(orders);
+                stale += 1;
+                if (units >= p.lb && (double)units / chosenCount > bestScore) {
+                    bestScore = (double)units / chosenCount;
+                    result.solution = Solution();
+                    result.solution.mOrders.insert(orders.begin(), orders.end());
+                    for (size_t i = 0; i < aisleAt.size(); i += 1)
+                        if (chosen[i]) result.solution.mAisles.insert(aisleAt[i]);
+                    stale = 0;
+                }
+            }
+
+            for (size_t i = 0; i < aisleAt.size(); i += 1)
+                if (chosen[i]) addStock(aisleAt[i], -1);
+            chosen.reset();
+            chosenCount = 0;
+        }
+
+        void branch(size_t i) {
+            if (!tick() || i == aisleAt.size()) return;
+            if (bound(i, chosenCount + 1) <= bestScore) return;
+
+            // Include: not while an aisle that dominates it was left out
+            if ((dominators[i] & before[i] & ~chosen).none()) {
+                chosen[i] = 1;
+                chosenCount += 1;
+                addStock(aisleAt[i], 1);
+                evaluate();
+                branch(i + 1);
+                addStock(aisleAt[i], -1);
+                chosenCount -= 1;
+                chosen[i] = 0;
+            }
+
+            // Exclude: not while an aisle it dominates is in
+            if ((dominated[i] & chosen).none()) {
+                addReachable(aisleAt[i], -1);
+                branch(i + 1);
+                addReachable(aisleAt[i], 1);
+            }
+        }
+
+    public:
+        BranchAndBound(const Problem &p) : p(p) {
+            demand.assign(p.itemCount, 0);
+            for (const auto &order : p.orders)
+                for (const auto &line : order) demand[line.ff] += line.ss;
+
+            vector<pair<ll, int>> byStock;
+            for (size_t a = 0; a < p.aisles.size(); a += 1) {
+                ll u = 0;
+                for (const auto &line : p.aisles[a]) u += min<ll>(line.ss, demand[line.ff]);
+                if (u > 0) byStock.push_back({-u, (int)a});
+            }
+            std::sort(byStock.begin(), byStock.end());
+            for (const auto &entry : byStock) {
+                aisleAt.push_back(entry.ss);
+                useful.push_back(-entry.ff);
+            }
+
+            // a is dominated by b when b has at least as much of every demanded
+            // item; equal aisles are ordered by position so only one of them wins
+            size_t n = aisleAt.size();
+            vector<vector<ll>> dense(n, vector<ll>(p.itemCount, 0));
+            for (size_t i = 0; i < n; i += 1)
+                for (const auto &line : p.aisles[aisleAt[i]])
+                    dense[i][line.ff] = min<ll>(line.ss, demand[line.ff]);
+            auto covers = [&](size_t b, size_t a) {
+                for (const auto &line : p.aisles[aisleAt[a]])
+                    if (dense[a][line.ff] > dense[b][line.ff]) return false;
+                return true;
+            };
+
+            dominators.assign(n, Aisles());
+            dominated.assign(n, Aisles());
+            before.assign(n, Aisles());
+            for (size_t a = 0; a < n; a += 1) {
+                if (a > 0) { before[a] = before[a - 1]; before[a][a - 1] = 1; }
+                for (size_t b = 0; b < n; b += 1) {
+                    if (a == b || !covers(b, a)) continue;
+                    if (covers(a, b) && b > a) continue;
+                    dominators[a][b] = 1;
+                    dominated[b][a] = 1;
+                }
+            }
+
+            stock.assign(p.itemCount, 0);
+            reachable.assign(p.itemCount, 0);
+            for (int a : aisleAt) addReachable(a, 1);
+
+            weight.assign(p.itemCount, 1.0);
+            multiplicity.assign(p.itemCount, 0);
+            orderUnits.assign(p.orders.size(), 0);
+            for (int a : aisleAt) {
+                int items = 0;
+                for (const auto &line : p.aisles[a]) items += demand[line.ff] > 0;
+                for (const auto &line : p.aisles[a])
+                    weight[line.ff] = min(weight[line.ff], 1.0 / items);
+            }
+            for (size_t o = 0; o < p.orders.size(); o += 1) {
+                for (const auto &line : p.orders[o]) {
+                    multiplicity[line.ff] += 1;
+                    orderUnits[o] += line.ss;
+                }
+            }
+            byUnits.resize(p.orders.size());
+            iota(byUnits.begin(), byUnits.end(), 0);
+            std::sort(byUnits.begin(), byUnits.end(), [&](int a, int b) { return orderUnits[a] > orderUnits[b]; });
+        }
+
+        Result solve() {
+            deadline = chrono::high_resolution_clock::now() + TIME_LIMIT;
+            seed();
+            branch(0);
+            result.optimal = !aborted;
+            return result;
+        }
+    };
+
+    Result solve(const Problem &p) {
+        if (!applicable(p)) return Result();
+        return BranchAndBound(p).solve();
+    }
+}
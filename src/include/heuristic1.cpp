@@ -1,11 +1,11 @@
 #include "./common.hpp"
+#include "./params.hpp"
 
 namespace Heur1 {
-    void construction(const Problem &p, Solution& temp) {
-        random_device rd;
-        mt19937 rng(rd());
+    void construction(const Problem &p, Solution& temp, const Params &params = Params()) {
+        mt19937 rng(Seed::next());
 
-        const double alpha = 0.3;
+        const double alpha = params.alphaGreedy;
     
         vector<int> candidates(p.orders.size());
         iota(candidates.begin(), candidates.end(), 0);
@@ -1,119 +1,222 @@
 #include "common.hpp"
 #include "caches.hpp"
+#include "team.hpp"
+#include "params.hpp"
 
 namespace HeurCached {
-    void construction(const Problem &p, const Caches &c, State& state) {
-        random_device rd;
-        mt19937 rng(rd());
-
-        vector<int> candidates(p.orders.size());
-        iota(candidates.begin(), candidates.end(), 0);
-
-        const double alpha = 0.5;
-
-        while (!candidates.empty()) {
-            vector<pair<double, int>> rcl;
-            double minCost = 1e18, maxCost = -1e18;
-            
-            // 1. Evaluate Candidates
-            // We use a simplified cost estimation to avoid full State cloning
-            for (int orderIdx : candidates) {
-                // Fast Bounds Check
-                if (state.currentTotalUnits + c.orderTotalUnits[orderIdx] > p.ub) continue;
-                
-                // Heuristic Score Calculation
-                // Benefit: Units gained
-                // Cost: Estimated new aisles needed.
-                
-                int estimatedNewAisles = 0;
-                // Check a sample of items in the order
-                for(const auto& line : p.orders[orderIdx]) {
-                    int item = line.ff;
-                    int qty = line.ss;
-                    // If we have a deficit or will cause one
-                    if (state.itemBalance[item] < qty) {
-                        // Very rough estimate: 1 aisle per missing item type?
-                        // Or check if the best aisle for this item is already selected?
-                        bool coveredBySelected = false;
-                        // Fast check: is the Top 1 aisle for this item already in our solution?
-                        if (!c.itemToAisles[item].empty()) {
-                            int bestAisle = c.itemToAisles[item][0].second;
-                            if (state.aisleSelected[bestAisle]) coveredBySelected = true;
-                        }
-                        if (!coveredBySelected) estimatedNewAisles++;
-                    }
-                }
-                
-                double score = (log(state.currentTotalUnits + c.orderTotalUnits[orderIdx])
-                        - log(state.aisleSolution.size() + estimatedNewAisles));
+    // GRASP construction over buckets. Orders sit in buckets by their
+    // estimated new aisles, each a max-heap by units, so within a bucket the
+    // score order never changes and each step only looks at the bucket tops.
+    // After a pick, only the orders of items whose balance changed (which
+    // covers their top aisle being selected) are re-estimated, in one batch;
+    // their old heap entries go stale and are skipped when they surface.
+    template<typename L>
+    void construction(const Problem &p, const Caches<L> &c, State<L> &state, const Params &params = Params()) {
+        mt19937 rng(Seed::next());
+
+        const double alpha = params.alphaCached;
+        const size_t RCL_SIZE = max(1, params.rclSize);
+        vector<uint8_t> fits;
+        vector<int> newAisles;
+
+        // buckets[n]: heap of {units, order, version} estimated to need n new aisles
+        vector<vector<tuple<ll, int, int>>> buckets;
+        // Bumped on every re-estimate; a picked order is never pushed again
+        vector<int> version(p.orders.size(), 0);
+        vector<char> picked(p.orders.size(), 0);
+        auto push = [&](int n, int orderIdx) {
+            if ((int)buckets.size() <= n) buckets.resize(n + 1);
+            buckets[n].push_back({c.orderTotalUnits[orderIdx], orderIdx, version[orderIdx]});
+            std::push_heap(buckets[n].begin(), buckets[n].end());
+        };
 
-                rcl.push_back({score, orderIdx});
-                if(score < minCost) minCost = score;
-                if(score > maxCost) maxCost = score;
+        // An order that does not fit needs some aisle even when the top aisle
+        // of its short items is already in (its stock went to other orders)
+        state.screenAllOrders(fits, &newAisles);
+        for (int orderIdx = 0; orderIdx < (int)p.orders.size(); orderIdx += 1) {
+            picked[orderIdx] = state.orderSelected[orderIdx];
+            if (!picked[orderIdx]) push(max(newAisles[orderIdx], 1 - fits[orderIdx]), orderIdx);
+        }
+
+        vector<int> dirty;
+
+        // {score, order, bucket}
+        vector<tuple<double, int, int>> rcl;
+        vector<size_t> finalCandidates;
+        while (true) {
+            // 1. Evaluate the tops of every bucket
+            rcl.clear();
+            for (int n = 0; n < (int)buckets.size(); n += 1) {
+                auto &bucket = buckets[n];
+                size_t taken = 0;
+                while (!bucket.empty() && taken < RCL_SIZE) {
+                    std::pop_heap(bucket.begin(), bucket.end());
+                    auto [units, orderIdx, stamp] = bucket.back();
+                    bucket.pop_back();
+                    if (stamp != version[orderIdx] || picked[orderIdx]) continue;
+                    // Units only grow, so an order over ub never fits again
+                    if (state.currentTotalUnits + units > p.ub) continue;
+
+                    double score = (log(state.currentTotalUnits + units)
+                            - log(state.aisleSolution.size() + n));
+                    rcl.push_back({score, orderIdx, n});
+                    taken += 1;
+                }
             }
 
             if (rcl.empty()) break;
 
-            // 2. Filter RCL
+            // 2. Filter RCL among the best RCL_SIZE
+            std::sort(rcl.begin(), rcl.end(), std::greater<>());
+            double maxCost = get<0>(rcl.front()), minCost = get<0>(rcl[min(rcl.size(), RCL_SIZE) - 1]);
             double threshold = maxCost - alpha * (maxCost - minCost);
-            vector<int> finalCandidates;
-            for(auto& pair : rcl) {
-                if(pair.first >= threshold) finalCandidates.push_back(pair.second);
-            }
+            finalCandidates.clear();
+            for (size_t k = 0; k < rcl.size() && k < RCL_SIZE; k += 1)
+                if (get<0>(rcl[k]) >= threshold) finalCandidates.push_back(k);
 
-            if (finalCandidates.empty()) finalCandidates.push_back(rcl[0].second); // Safety
+            // 3. Pick & Update; the rest goes back unchanged
+            size_t chosen = finalCandidates[uniform_int_distribution<size_t>(0, finalCandidates.size() - 1)(rng)];
+            int pick = get<1>(rcl[chosen]);
+            picked[pick] = 1;
+            for (size_t k = 0; k < rcl.size(); k += 1)
+                if (k != chosen) push(get<2>(rcl[k]), get<1>(rcl[k]));
 
-            // 3. Pick & Update
-            int i = uniform_int_distribution<>(0, finalCandidates.size() - 1)(rng);
-            int pick = finalCandidates[i];
+            size_t mark = state.checkpoint();
             state.addOrder(pick);
-            
+
             // Repair the solution (add aisles to cover new deficits)
             if (state.addAislesToRepairSolution() == -1) {
                 // If repair fails (impossible), rollback
                 state.removeOrder(pick);
             }
 
-            // Remove from candidates list
-            candidates.erase(std::remove(candidates.begin(), candidates.end(), pick), candidates.end());
+            // 4. Re-estimate the orders that share an item with the change
+            state.ordersTouchedSince(mark, dirty);
+            state.commit(mark);
+            dirty.erase(std::remove_if(dirty.begin(), dirty.end(), [&](int o) { return picked[o]; }), dirty.end());
+            state.screenOrders(dirty.data(), dirty.size(), fits, newAisles);
+            for (size_t k = 0; k < dirty.size(); k += 1) {
+                int orderIdx = dirty[k];
+                version[orderIdx] += 1;
+                push(max(newAisles[k], 1 - fits[k]), orderIdx);
+            }
         }
-        
+
         // Final cleanup
         state.pruneAislesToFitOrders();
     }
 
-    void refinement(const Problem &p, const Caches &c, State& state) {
-        random_device rd;
-        mt19937 rng(rd());
+    // A DROP move scored without touching the state: the order's units go
+    // back to its items in a private overlay on itemBalance, and the visited
+    // aisles sharing an item with it are pruned greedily against the overlay.
+    // Applying exactly that order and those aisles gives exactly that score.
+    struct DropMove {
+        double score = 0.0;
+        int order = -1;
+        vector<int> aisles;
+    };
+
+    struct DropScratch {
+        vector<ll> delta;
+        vector<int> items, aisles;
+        DropMove best;
+    };
+
+    template<typename L>
+    double evaluateDrop(const Problem &p, const Caches<L> &c, const State<L> &state, int orderIdx, DropScratch &s) {
+        s.delta.resize(p.itemCount + 1, 0);
+        s.items.clear();
+        s.aisles.clear();
+        auto shift = [&](int item, ll by) {
+            if (s.delta[item] == 0) s.items.push_back(item);
+            s.delta[item] += by;
+        };
+
+        for (const auto &line : p.orders[orderIdx]) shift(line.ff, line.ss);
+        for (const auto &posting : c.orderToAisles[orderIdx]) {
+            int aisleIdx = posting.second;
+            if (!state.aisleSelected[aisleIdx]) continue;
+            bool removable = true;
+            for (const auto &line : p.aisles[aisleIdx])
+                if (state.itemBalance[line.ff] + s.delta[line.ff] < line.ss) { removable = false; break; }
+            if (!removable) continue;
+            for (const auto &line : p.aisles[aisleIdx]) shift(line.ff, -line.ss);
+            s.aisles.push_back(aisleIdx);
+        }
+        for (int item : s.items) s.delta[item] = 0;
+
+        size_t aisles = state.aisleSolution.size() - s.aisles.size();
+        ll units = state.currentTotalUnits - c.orderTotalUnits[orderIdx];
+        if (aisles == 0 || units < p.lb) return 0.0;
+        return (double)units / aisles;
+    }
+
+    // Best DROP over `orders`, split across the team against the unchanged
+    // state. Returns false when no drop beats `currentScore`.
+    template<typename L>
+    bool bestDrop(const Problem &p, const Caches<L> &c, const State<L> &state, Team &team,
+                  vector<DropScratch> &scratch, const vector<int> &orders, double currentScore, DropMove &move) {
+        scratch.resize(team.size());
+        for (auto &s : scratch) {
+            s.best.score = currentScore + 1e-9;
+            s.best.order = -1;
+        }
+        team.run(orders.size(), [&](size_t begin, size_t end, size_t worker) {
+            DropScratch &s = scratch[worker];
+            for (size_t i = begin; i < end; i += 1) {
+                double score = evaluateDrop(p, c, state, orders[i], s);
+                if (score <= s.best.score) continue;
+                s.best.score = score;
+                s.best.order = orders[i];
+                s.best.aisles = s.aisles;
+            }
+        });
+
+        move.order = -1;
+        for (auto &s : scratch)
+            if (s.best.order != -1 && (move.order == -1 || s.best.score > move.score)) move = s.best;
+        return move.order != -1;
+    }
+
+    // With a team, the DROP scan is split across its threads and the best
+    // drop is committed after the barrier; without one, the first improving
+    // drop is taken, one evaluation after another.
+    template<typename L>
+    void refinement(const Problem &p, const Caches<L> &c, State<L> &state, const Params &params = Params(),
+                    Team *team = nullptr) {
+        mt19937 rng(Seed::next());
+        vector<DropScratch> dropScratch;
+        vector<int> selectedOrders;
+        DropMove drop;
 
         // We clear aisles and rebuild them optimally for the current orders
         // This is often better than trusting the input aisles
         state.addAislesToRepairSolution();
         state.pruneAislesToFitOrders();
 
+        vector<uint8_t> fits;
+
         bool improved = true;
         while (improved) {
             improved = false;
             double currentScore = state.calculateScore();
 
-            // Get unselected orders
-            vector<int> unselected;
-            for(int i = 0; i < p.orders.size(); i += 1)
-                if(!state.orderSelected[i]) unselected.push_back(i);
-
             // --- MOVE: ADD ---
             // Try to add an order if it fits UB and improves score
-            // We specifically look for "Free Fills" first (no new aisles needed)
-            for (int u : unselected) {
-                if (state.canFitOrder(u)) {
+            // We specifically look for "Free Fills" first (no new aisles needed),
+            // found for every unselected order in one screening pass. Each add
+            // only uses up stock, so later candidates get a canFitOrder recheck.
+            if (state.screenAllOrders(fits) > 0) {
+                for (int u = 0; u < p.orders.size(); u += 1) {
+                    if (!fits[u] || (improved && !state.canFitOrder(u))) continue;
                     // Try adding
                     state.addOrder(u);
-                    
+
                     double newScore = state.calculateScore();
-                    
+
                     if (state.isFeasible() && newScore > currentScore + 1e-9) {
                         improved = true;
-                        break;
+                        currentScore = newScore;
                     } else {
                         state.removeOrder(u);
                     }
@@ -123,53 +226,106 @@ namespace HeurCached {
 
             // --- MOVE: DROP & REPAIR ---
             // Try removing an order to see if we can drop massive amounts of aisles
-            auto scanning = state.orderSolution;
+            if (team && team->size() > 1) {
+                // Redundant aisles go first, as in the serial scan: a drop is
+                // only credited with the aisles its own order frees
+                improved = !state.pruneAislesToFitOrders().empty();
+                currentScore = state.calculateScore();
+                selectedOrders.assign(state.orderSolution.begin(), state.orderSolution.end());
+                if (bestDrop(p, c, state, *team, dropScratch, selectedOrders, currentScore, drop)) {
+                    state.removeOrder(drop.order);
+                    for (int aisleIdx : drop.aisles) state.removeAisle(aisleIdx);
+                    state.pruneAislesToFitOrders();
+                    improved = true;
+                }
+                if (improved) continue;
+            }
+            auto scanning = team && team->size() > 1 ? std::unordered_set<int>() : state.orderSolution;
             for (int orderIdx: scanning) {
-                // Snapshot state logic is hard with mutable structs without copying.
-                // We will just do the operation and reverse it if it fails.
-                
+                // Do the operation under a checkpoint and roll it back if it fails.
+                size_t mark = state.checkpoint();
+
                 // 1. Remove Order
                 state.removeOrder(orderIdx);
                 
                 // 2. Prune Aisles (This is the heavy part)
                 // We need to see if removing this order allows removing aisles.
-                auto removedAisles = state.pruneAislesToFitOrders();
+                state.pruneAislesToFitOrders();
 
-                double newScore = (double)state.currentTotalUnits / (double)state.aisleSelected.size();
+                double newScore = state.calculateScore();
 
                 if (newScore > currentScore + 1e-9 && state.currentTotalUnits >= p.lb) {
+                    state.commit(mark);
                     improved = true;
                     break;
                 } else {
-                    // Revert: Add order back
-                    state.addOrder(orderIdx);
-                    // Restore aisles
-                    for(auto a: removedAisles) state.addAisle(a);
+                    state.rollback(mark);
                 }
             }
             if (improved) continue;
 
             // Add an aisle
             if(!p.aisles.empty()) {
-                std::vector<size_t> aisleCandidates(16);
-                for(auto &aisle: aisleCandidates)
-                    aisle = uniform_int_distribution<>(0, p.aisles.size() - 1)(rng);
-    
+                // Half the candidates are random, half look like an aisle we already visit
+                std::vector<size_t> aisleCandidates;
+                if(!state.aisleSolution.empty()) {
+                    auto it = state.aisleSolution.begin();
+                    std::advance(it, uniform_int_distribution<>(0, state.aisleSolution.size() - 1)(rng));
+                    for(int a : c.similarity.similarAisles(*it, max(0, params.similarAisles))) aisleCandidates.push_back(a);
+                }
+                while(aisleCandidates.size() < (size_t)max(1, params.aisleCandidates))
+                    aisleCandidates.push_back(uniform_int_distribution<>(0, p.aisles.size() - 1)(rng));
+
                 size_t bestAisle = aisleCandidates[0];
-                int newItems = state.estimateNewItemsForAisle(bestAisle);
+                ll newItems = state.gainOfAisle(bestAisle);
                 for(size_t i = 1; i < aisleCandidates.size(); i += 1) {
-                    int newItems2 = state.estimateNewItemsForAisle(bestAisle);
+                    ll newItems2 = state.gainOfAisle(aisleCandidates[i]);
                     if(newItems2 > newItems) {
                         bestAisle = aisleCandidates[i];
                         newItems = newItems2;
                     }
                 }
 
-                double newScore = (double)(state.currentTotalUnits + newItems) / (state.aisleSelected.size() + 1);
-                if(newScore > currentScore) {
+                // The gain is still optimistic (partial supplies count), so
+                // try the move for real and undo it if the ratio did not improve.
+                double boundScore = (double)(state.currentTotalUnits + newItems) / (state.aisleSolution.size() + 1);
+                if(newItems > 0 && boundScore > currentScore) {
+                    size_t mark = state.checkpoint();
                     state.addAisleWithOrdersGreedy(bestAisle);
-                    improved = true;
+                    if(state.calculateScore() > currentScore + 1e-9) {
+                        state.commit(mark);
+                        improved = true;
+                    } else {
+                        state.rollback(mark);
+                    }
+                }
+            }
+            if (improved) continue;
+
+            // --- MOVE: SWAP AISLE ---
+            // Replace a visited aisle by a similar one and let the repair cover the rest.
+            // Only pays off when it ends with fewer aisles for the same orders.
+            vector<int> visited(state.aisleSolution.begin(), state.aisleSolution.end());
+            std::shuffle(visited.begin(), visited.end(), rng);
+            if(visited.size() > 8) visited.resize(8);
+            for (int out : visited) {
+                for (int in : c.similarity.similarAisles(out, 4)) {
+                    if (state.aisleSelected[in]) continue;
+
+                    size_t mark = state.checkpoint();
+                    state.removeAisle(out);
+                    state.addAisle(in);
+                    bool repaired = state.addAislesToRepairSolution() != -1;
+                    if (repaired) state.pruneAislesToFitOrders();
+
+                    if (repaired && state.isFeasible() && state.calculateScore() > currentScore + 1e-9) {
+                        state.commit(mark);
+                        improved = true;
+                        break;
+                    }
+                    state.rollback(mark);
                 }
+                if (improved) break;
             }
             if (improved) continue;
         }
@@ -1,132 +1,109 @@
 #include "common.hpp"
 #include "caches.hpp"
+#include "sampler.hpp"
+#include "params.hpp"
 
 namespace Heur3 {
-    void construction(const Problem &p, const Caches &c, State &state) {
+    template<typename L>
+    void construction(const Problem &p, const Caches<L> &c, State<L> &state, const Params &params = Params()) {
         // 1. Setup State and RNG
-        static thread_local std::mt19937 rng(std::random_device{}());
+        static thread_local std::mt19937 rng(Seed::next());
 
         // Candidates pool management
-        // We use a swapping technique to remove items in O(1) without 'erase()'
-        vector<int> candidates(p.orders.size());
-        iota(candidates.begin(), candidates.end(), 0);
+        // Orders are drawn in proportion to units per estimated aisle from a
+        // Fenwick sampler. Weights change only for the orders that share an
+        // item with the last change; a weight of 0 takes an order out.
+        const double alpha = params.alphaSampled;
+        const int SAMPLE_MIN = max(1, params.sampleMin), SAMPLE_MAX = max(SAMPLE_MIN, params.sampleMax);
+        const double SPREAD_FULL = params.spreadFull; // Score spread (in log) that calls for the full sample
+        vector<int> sampleOrders, newAisles, touched;
+        vector<uint8_t> fits;
+        vector<char> picked(p.orders.size(), 0);
 
-        const double alpha = 0.5;     
-        const int SAMPLE_SIZE = 80; // Constant sample size = Linear Complexity
+        auto weightOf = [&](int orderIdx, int estimate, bool fit) {
+            if (picked[orderIdx] || state.currentTotalUnits + c.orderTotalUnits[orderIdx] > p.ub) return 0.0;
+            // An order that does not fit needs some aisle, whatever the estimate says
+            return (double)c.orderTotalUnits[orderIdx] / (1 + max(estimate, fit ? 0 : 1));
+        };
+
+        state.screenAllOrders(fits, &newAisles);
+        vector<double> initial(p.orders.size());
+        for (size_t o = 0; o < p.orders.size(); o += 1) {
+            picked[o] = state.orderSelected[o];
+            initial[o] = weightOf(o, newAisles[o], fits[o]);
+        }
+        Sampler::Fenwick sampler(initial);
+
+        // Biggest orders first: those past the ub slack leave for good, as units only grow
+        vector<int> byUnits(p.orders.size());
+        iota(byUnits.begin(), byUnits.end(), 0);
+        std::sort(byUnits.begin(), byUnits.end(), [&](int a, int b) { return c.orderTotalUnits[a] > c.orderTotalUnits[b]; });
+        size_t oversized = 0;
+
+        int sampleSize = SAMPLE_MAX;
 
         // 2. Main Loop: Runs at most N times
-        while (!candidates.empty()) {
-            
+        while (true) {
+            while (oversized < byUnits.size()
+                    && state.currentTotalUnits + c.orderTotalUnits[byUnits[oversized]] > p.ub)
+                sampler.set(byUnits[oversized++], 0.0);
+            if (sampler.empty()) break;
+
             // --- A. Sampling (Tournament) ---
-            // We pick 'SAMPLE_SIZE' random indices from the *valid* range [0, valid_count-1]
-            
-            vector<pair<double, int>> sampleRCL; // {Score, Index_In_Candidates_Array}
-            double minScore = 1e18, maxScore = -1e18;
-            
-            int attempts = min<int>(candidates.size(), SAMPLE_SIZE);
-            
-            for(int k = 0; k < attempts; ++k) {
-                // Pick random index from valid range
-                int randPos = std::uniform_int_distribution<>(0, candidates.size() - 1)(rng);
-                int orderIdx = candidates[randPos];
-                
-                // --- B. Fast Evaluation ---
-                
-                // 1. Strict Bounds Check
-                if (state.currentTotalUnits + c.orderTotalUnits[orderIdx] > p.ub) {
-                    // Score -1.0 signifies "Invalid/Poison"
-                    sampleRCL.push_back({-1.0, randPos});
-                    continue;
-                }
-
-                // 2. Adaptive Score Calculation (Same as quadratic version)
-                int estimatedNewAisles = 0;
-                
-                for(const auto& line : p.orders[orderIdx]) {
-                    int item = line.ff;
-                    int qty = line.ss;
-                    
-                    if (state.itemBalance[item] < qty) {
-                        bool covered = false;
-                        if (!c.itemToAisles[item].empty()) {
-                            int t1a = c.itemToAisles[item][0].second;
-                            if (state.aisleSelected[t1a]) covered = true;
-                        }
-                        if (!covered) estimatedNewAisles++;
-                    }
-                }
+            sampleOrders.clear();
+            for (int k = 0; k < sampleSize; ++k) {
+                int orderIdx = sampler.sample(rng);
+                if (sampler.weight(orderIdx) > 0) sampleOrders.push_back(orderIdx);
+            }
+            if (sampleOrders.empty()) continue;
+            state.screenOrders(sampleOrders.data(), sampleOrders.size(), fits, newAisles);
 
+            // --- B. Fast Evaluation ---
+            vector<pair<double, int>> sampleRCL; // {Score, Order}
+            double minScore = 1e18, maxScore = -1e18;
+            for (size_t k = 0; k < sampleOrders.size(); ++k) {
+                int orderIdx = sampleOrders[k];
                 double score = (log(state.currentTotalUnits + c.orderTotalUnits[orderIdx])
-                        - log(state.aisleSolution.size() + estimatedNewAisles));
-                
-                // Store {Score, Position_In_Array} so we can swap-pop later
-                sampleRCL.push_back({score, randPos});
-                
-                if (score > maxScore) maxScore = score;
-                if (score < minScore && score > -0.5) minScore = score;
+                        - log(state.aisleSolution.size() + max(newAisles[k], 1 - fits[k])));
+                sampleRCL.push_back({score, orderIdx});
+                maxScore = max(maxScore, score);
+                minScore = min(minScore, score);
             }
 
+            // Tight scores need few samples, spread ones more
+            double spread = min(1.0, (maxScore - minScore) / SPREAD_FULL);
+            sampleSize = SAMPLE_MIN + (int)((SAMPLE_MAX - SAMPLE_MIN) * spread);
+
             // --- C. Selection (RCL on Sample) ---
-            
-            // Filter valid candidates from the sample
-            vector<int> validSamplePositions;
+            vector<int> validSample;
             double threshold = maxScore - alpha * (maxScore - minScore);
+            for (auto &s : sampleRCL)
+                if (s.first >= threshold) validSample.push_back(s.second);
 
-            for(auto& s : sampleRCL) {
-                if (s.first < -0.5) continue; // Skip bounds violations
-                if (s.first >= threshold) {
-                    validSamplePositions.push_back(s.second);
-                }
-            }
+            int orderIdx = validSample[std::uniform_int_distribution<>(0, (int)validSample.size() - 1)(rng)];
 
-            int chosenPos = -1;
-            bool tryToAdd = false;
-
-            if (validSamplePositions.empty()) {
-                // All sampled items were bad (hit UB). 
-                // We must remove *one* of them to ensure progress (avoid infinite loop).
-                // We pick the first sampled one to discard.
-                if (!sampleRCL.empty()) chosenPos = sampleRCL[0].second;
-                else chosenPos = std::uniform_int_distribution<>(0, candidates.size() - 1)(rng);
-                tryToAdd = false; // Just discard, don't try to add
-            } else {
-                // Pick one from RCL
-                int rIdx = std::uniform_int_distribution<>(0, (int)validSamplePositions.size() - 1)(rng);
-                chosenPos = validSamplePositions[rIdx];
-                tryToAdd = true;
-            }
-            
             // --- D. Commit & Repair (The Critical Safety Check) ---
-            
-            if (tryToAdd) {
-                int orderIdx = candidates[chosenPos];
-                
-                // 1. Add Order to State
-                state.addOrder(orderIdx);
-                
-                // 2. Exact Repair (The slow but safe check)
-                // If this fails, we MUST rollback to stay feasible.
-                if (state.addAislesToRepairSolution() != -1) {
-                    // Success! Keep it.
-                } else {
-                    // Failure! Rollback.
-                    state.removeOrder(orderIdx);
-                    // We don't add it to temp.mOrders
-                    // We WILL remove it from candidates below so we don't retry it.
-                }
+            // Whether it stays or not, we are done with this candidate for this run
+            picked[orderIdx] = 1;
+            sampler.set(orderIdx, 0.0);
+
+            size_t mark = state.checkpoint();
+            state.addOrder(orderIdx);
+
+            // Exact Repair (The slow but safe check)
+            // If this fails, we MUST rollback to stay feasible.
+            if (state.addAislesToRepairSolution() == -1) {
+                state.removeOrder(orderIdx);
             }
 
-            // --- E. Removal ---
-            // Whether we successfully added it, failed to repair it, or it hit UB,
-            // we are done with this candidate for this construction run.
-            
-            // Swap chosen element with the last valid element
-            std::swap(candidates[chosenPos], candidates.back());
-            
-            // Shrink the valid range
-            candidates.pop_back();
+            // --- E. Reweight the orders that share an item with the change ---
+            state.ordersTouchedSince(mark, touched);
+            state.commit(mark);
+            state.screenOrders(touched.data(), touched.size(), fits, newAisles);
+            for (size_t k = 0; k < touched.size(); k += 1)
+                sampler.set(touched[k], weightOf(touched[k], newAisles[k], fits[k]));
         }
-        
+
         // Final cleanup
         state.pruneAislesToFitOrders();
     }
@@ -1,81 +1,70 @@
 #include "common.hpp"
 #include "caches.hpp"
+#include "sampler.hpp"
+#include "params.hpp"
 
 namespace Heur4 {
-    void construction(const Problem &p, const Caches &c, State& state) {
+    template<typename L>
+    void construction(const Problem &p, const Caches<L> &c, State<L> &state, const Params &params = Params()) {
         // 1. Setup State and RNG
-        static thread_local std::mt19937 rng(std::random_device{}());
+        static thread_local std::mt19937 rng(Seed::next());
 
         // Candidates pool management
-        // We use a swapping technique to remove items in O(1) without 'erase()'
-        vector<int> aisleCandidates(p.aisles.size());
-        iota(aisleCandidates.begin(), aisleCandidates.end(), 0);
+        // Aisles are drawn in proportion to their gain bound from a Fenwick
+        // sampler; only the aisles whose bound moved are reweighted. The
+        // drawn ones are scored by the balance-aware gain.
+        const double alpha = params.alphaSampled;
+        const int SAMPLE_MIN = max(1, params.sampleMin), SAMPLE_MAX = max(SAMPLE_MIN, params.sampleMax);
+        const double SPREAD_FULL = params.spreadFull; // Score spread (in log) that calls for the full sample
+        vector<int> sample, touched;
 
-        const double alpha = 0.5;
-        const int SAMPLE_SIZE = 80; // Constant sample size = Linear Complexity
+        vector<double> initial(p.aisles.size());
+        for (size_t a = 0; a < p.aisles.size(); a += 1) initial[a] = state.gainBoundOfAisle(a);
+        Sampler::Fenwick sampler(initial);
+
+        int sampleSize = SAMPLE_MAX;
 
         // 2. Main Loop: Runs at most N times
-        while (!aisleCandidates.empty()) {
+        while (!sampler.empty()) {
             if (state.isFeasible()) break;
 
             // --- A. Sampling (Tournament) ---
-            // We pick 'SAMPLE_SIZE' random indices from the *valid* range [0, valid_count-1]
+            sample.clear();
+            for (int k = 0; k < sampleSize; ++k) {
+                int aisleIdx = sampler.sample(rng);
+                if (sampler.weight(aisleIdx) > 0) sample.push_back(aisleIdx);
+            }
+            if (sample.empty()) continue;
 
-            vector<pair<double, int>> sampleRCL; // {Score, Index_In_Candidates_Array}
+            // --- B. Fast Evaluation ---
+            vector<pair<double, int>> sampleRCL; // {Score, Aisle}
             double minScore = 1e18, maxScore = -1e18;
-
-            int attempts = min<int>(aisleCandidates.size(), SAMPLE_SIZE);
-            
-            for(int k = 0; k < attempts; ++k) {
-                // Pick random index from valid range
-                int randPos = std::uniform_int_distribution<>(0, aisleCandidates.size() - 1)(rng);
-                int aisleIndex = aisleCandidates[randPos];
-
-                // --- B. Fast Evaluation ---
-
-                int estimatedNewItems = state.estimateNewItemsForAisle(aisleIndex);
+            for (int aisleIdx : sample) {
+                ll estimatedNewItems = state.gainOfAisle(aisleIdx);
                 double score = log(state.currentTotalUnits + estimatedNewItems);
-
-                // Store {Score, Position_In_Array} so we can swap-pop later
-                sampleRCL.push_back({score, randPos});
-
-                if (score > maxScore) maxScore = score;
-                if (score < minScore && score > -0.5) minScore = score;
+                sampleRCL.push_back({score, aisleIdx});
+                maxScore = max(maxScore, score);
+                minScore = min(minScore, score);
             }
 
-            // --- C. Selection (RCL on Sample) ---
+            // Tight scores need few samples, spread ones more
+            double spread = min(1.0, (maxScore - minScore) / SPREAD_FULL);
+            sampleSize = SAMPLE_MIN + (int)((SAMPLE_MAX - SAMPLE_MIN) * spread);
 
-            // Filter valid candidates from the sample
-            vector<int> validSamplePositions;
+            // --- C. Selection (RCL on Sample) ---
+            vector<int> validSample;
             double threshold = maxScore - alpha * (maxScore - minScore);
+            for (auto &s : sampleRCL)
+                if (s.first >= threshold) validSample.push_back(s.second);
 
-            for(auto& s : sampleRCL) {
-                if (s.first < -0.5) continue; // Skip bounds violations
-                if (s.first >= threshold) {
-                    validSamplePositions.push_back(s.second);
-                }
-            }
-
-            int chosenPos = -1;
-            if (validSamplePositions.empty()) {
-                // All sampled items were bad (hit UB). 
-                // We must remove *one* of them to ensure progress (avoid infinite loop).
-                // We pick the first sampled one to discard.
-                if (!sampleRCL.empty()) chosenPos = sampleRCL[0].second;
-                else chosenPos = std::uniform_int_distribution<>(0, aisleCandidates.size() - 1)(rng);
-            } else {
-                // Pick one from RCL
-                int rIdx = std::uniform_int_distribution<>(0, (int)validSamplePositions.size() - 1)(rng);
-                chosenPos = validSamplePositions[rIdx];
-                int aisleIdx = aisleCandidates[chosenPos];
-                state.addAisleWithOrdersGreedy(aisleIdx);
-            }
+            int aisleIdx = validSample[std::uniform_int_distribution<>(0, (int)validSample.size() - 1)(rng)];
 
-            // --- D. Removal ---
-            // Whether we successfully added it, failed to repair it, or it hit UB,
-            // we are done with this candidate for this construction run.
-            std::swap(aisleCandidates[chosenPos], aisleCandidates.back());
-            aisleCandidates.pop_back();
+            // --- D. Commit and reweight what the new orders touched ---
+            size_t mark = state.checkpoint();
+            state.addAisleWithOrdersGreedy(aisleIdx);
+            state.aislesTouchedSince(mark, touched);
+            state.commit(mark);
+            for (int a : touched) sampler.set(a, state.gainBoundOfAisle(a));
         }
     }
 }
@@ -0,0 +1,208 @@
+#include "common.hpp"
+#include "caches.hpp"
+#include "params.hpp"
+
+namespace Alns {
+    // What the repair needs to know about the iteration: the aisles visited
+    // before it started, sorted, so it can pack orders from the new ones.
+    // Undoing a rejected iteration is the State journal's job.
+    struct Move {
+        vector<int> aislesBefore;
+    };
+
+    enum Destroy { RANDOM_AISLES, RELATED_AISLES, WORST_ORDERS, DESTROY_COUNT };
+    enum Repair { GREEDY_AISLES, DROP_AND_OPEN, REINSERT_ORDERS, REPAIR_COUNT };
+
+    template<typename L>
+    void destroy(const Problem &, const Caches<L> &c, State<L> &state, int op, mt19937 &rng) {
+        vector<int> aisles(state.aisleSolution.begin(), state.aisleSolution.end());
+        if (aisles.empty()) return;
+        int q = uniform_int_distribution<>(1, max<int>(1, aisles.size() * 15 / 100))(rng);
+
+        if (op == RANDOM_AISLES) {
+            std::shuffle(aisles.begin(), aisles.end(), rng);
+            for (int i = 0; i < q && i < (int)aisles.size(); i += 1) state.removeAisle(aisles[i]);
+        } else if (op == RELATED_AISLES) {
+            // A seed aisle and the visited aisles whose stock looks like it
+            int seed = aisles[uniform_int_distribution<>(0, aisles.size() - 1)(rng)];
+            state.removeAisle(seed);
+            int removed = 1;
+            for (int a : c.similarity.similarAisles(seed, 4 * q)) {
+                if (removed >= q) break;
+                if (!state.aisleSelected[a]) continue;
+                state.removeAisle(a);
+                removed += 1;
+            }
+        } else {
+            // Lowest yield: few units for the number of visited aisles the order draws from
+            vector<pair<double, int>> yield;
+            for (int o : state.orderSolution) {
+                int served = 0;
+                for (const auto &posting : c.orderToAisles[o]) served += state.aisleSelected[posting.second];
+                yield.push_back({(double)c.orderTotalUnits[o] / max(1, served), o});
+            }
+            int k = min<int>(yield.size(), max<int>(1, yield.size() * 10 / 100));
+            std::nth_element(yield.begin(), yield.begin() + k - 1, yield.end());
+            for (int i = 0; i < k; i += 1) state.removeOrder(yield[i].second);
+        }
+    }
+
+    // Unselected orders back in by the HeurCached construction score, the
+    // log ratio after the new aisles screenAllOrders estimates, picked at
+    // random from the alpha band of the best rclSize. An insertion that does
+    // not raise the ratio, or whose deficit cannot be covered, is undone.
+    template<typename L>
+    void reinsertOrders(const Problem &p, const Caches<L> &c, State<L> &state, const Params &params, mt19937 &rng) {
+        const size_t RCL_SIZE = max(1, params.rclSize);
+        vector<uint8_t> fits;
+        vector<int> newAisles;
+        state.screenAllOrders(fits, &newAisles);
+
+        vector<pair<double, int>> rcl;
+        for (int o = 0; o < (int)p.orders.size(); o += 1) {
+            if (state.orderSelected[o] || state.currentTotalUnits + c.orderTotalUnits[o] > p.ub) continue;
+            int n = max(newAisles[o], 1 - fits[o]);
+            rcl.push_back({log(state.currentTotalUnits + c.orderTotalUnits[o]) - log(state.aisleSolution.size() + n), o});
+        }
+        if (rcl.empty()) return;
+        size_t top = min(rcl.size(), RCL_SIZE);
+        std::partial_sort(rcl.begin(), rcl.begin() + top, rcl.end(), std::greater<>());
+        rcl.resize(top);
+        double threshold = rcl.front().first - params.alphaCached * (rcl.front().first - rcl.back().first);
+        while (rcl.back().first < threshold) rcl.pop_back();
+        std::shuffle(rcl.begin(), rcl.end(), rng);
+
+        for (const auto &candidate : rcl) {
+            double before = state.calculateScore();
+            size_t mark = state.checkpoint();
+            state.addOrder(candidate.second);
+            if (state.addAislesToRepairSolution() != -1 && state.calculateScore() > before + 1e-9) state.commit(mark);
+            else state.rollback(mark);
+        }
+    }
+
+    template<typename L>
+    bool repair(const Problem &p, const Caches<L> &c, State<L> &state, int op, const Params &params, mt19937 &rng,
+                Move &move) {
+        if (op == DROP_AND_OPEN) {
+            // Drop the orders left short, then open the aisle with the best gain
+            state.dropOrdersToRepairSolution();
+
+            int best = -1;
+            ll bestGain = 0;
+            for (int a = 0; a < (int)p.aisles.size(); a += 1) {
+                if (state.aisleSelected[a]) continue;
+                ll gain = state.gainOfAisle(a);
+                if (best == -1 || gain > bestGain) best = a, bestGain = gain;
+            }
+            if (best != -1) state.addAisleWithOrdersGreedy(best);
+        }
+
+        // Cover whatever is still short, drop what became redundant, then pack
+        if (state.addAislesToRepairSolution() == -1) return false;
+        state.pruneAislesToFitOrders();
+
+        vector<int> visited(state.aisleSolution.begin(), state.aisleSolution.end());
+        for (int a : visited)
+            if (!std::binary_search(move.aislesBefore.begin(), move.aislesBefore.end(), a))
+                state.packOrdersFromAisle(a);
+        if (!visited.empty()) {
+            // Removed orders may have freed stock in aisles that stayed
+            state.packOrdersFromAisle(visited[uniform_int_distribution<>(0, visited.size() - 1)(rng)]);
+        }
+        if (op == REINSERT_ORDERS && state.isFeasible()) reinsertOrders(p, c, state, params, rng);
+        return state.isFeasible();
+    }
+
+    int roulette(const vector<double> &weights, mt19937 &rng) {
+        return std::discrete_distribution<>(weights.begin(), weights.end())(rng);
+    }
+
+    // Destroy/repair on the live State, each iteration under a journal
+    // checkpoint. Operator weights follow their recent success; worse
+    // solutions are accepted with simulated annealing.
+    template<typename L>
+    void search(const Problem &p, const Caches<L> &c, State<L> &state, const Params &params = Params()) {
+        static thread_local std::mt19937 rng(Seed::next());
+
+        const int MAX_ITERATIONS = 20000;
+        const int MAX_NON_IMPROVING = 1000;
+        const int SEGMENT = 50;
+        const double REACTION = 0.2;
+        const double SCORE_BEST = 33, SCORE_BETTER = 9, SCORE_ACCEPTED = 13;
+        const double COOLING = 0.9995;
+
+        if (!state.isFeasible()) return;
+
+        Solution best;
+        best.mOrders = state.orderSolution;
+        best.mAisles = state.aisleSolution;
+        double bestScore = state.calculateScore(), currentScore = bestScore;
+        double temperature = 0.05 * bestScore;
+
+        vector<double> destroyWeight(DESTROY_COUNT, 1.0), repairWeight(REPAIR_COUNT, 1.0);
+        vector<double> destroyGain(DESTROY_COUNT, 0.0), repairGain(REPAIR_COUNT, 0.0);
+        vector<int> destroyUsed(DESTROY_COUNT, 0), repairUsed(REPAIR_COUNT, 0);
+
+        int nonImproving = 0;
+        for (int iteration = 1; iteration <= MAX_ITERATIONS && nonImproving < MAX_NON_IMPROVING; iteration += 1) {
+            int d = roulette(destroyWeight, rng), r = roulette(repairWeight, rng);
+
+            Move move;
+            move.aislesBefore.assign(state.aisleSolution.begin(), state.aisleSolution.end());
+            std::sort(move.aislesBefore.begin(), move.aislesBefore.end());
+
+            size_t mark = state.checkpoint();
+            destroy(p, c, state, d, rng);
+            bool feasible = repair(p, c, state, r, params, rng, move);
+            double score = state.calculateScore();
+
+            double gain = 0;
+            if (feasible && score > bestScore + 1e-9) {
+                gain = SCORE_BEST;
+                bestScore = score;
+                best.mOrders = state.orderSolution;
+                best.mAisles = state.aisleSolution;
+                nonImproving = 0;
+            } else {
+                nonImproving += 1;
+                if (feasible && score > currentScore + 1e-9) gain = SCORE_BETTER;
+                else if (feasible && uniform_real_distribution<>(0, 1)(rng) < exp((score - currentScore) / max(temperature, 1e-9)))
+                    gain = SCORE_ACCEPTED;
+            }
+
+            if (gain > 0) {
+                currentScore = score;
+                state.commit(mark);
+            } else {
+                state.rollback(mark);
+            }
+
+            destroyGain[d] += gain; destroyUsed[d] += 1;
+            repairGain[r] += gain; repairUsed[r] += 1;
+            temperature *= COOLING;
+
+            if (iteration % SEGMENT == 0) {
+                for (int i = 0; i < DESTROY_COUNT; i += 1) {
+                    if (destroyUsed[i] > 0)
+                        destroyWeight[i] = (1 - REACTION) * destroyWeight[i] + REACTION * destroyGain[i] / destroyUsed[i];
+                    destroyWeight[i] = max(destroyWeight[i], 0.05);
+                    destroyGain[i] = 0; destroyUsed[i] = 0;
+                }
+                for (int i = 0; i < REPAIR_COUNT; i += 1) {
+                    if (repairUsed[i] > 0)
+                        repairWeight[i] = (1 - REACTION) * repairWeight[i] + REACTION * repairGain[i] / repairUsed[i];
+                    repairWeight[i] = max(repairWeight[i], 0.05);
+                    repairGain[i] = 0; repairUsed[i] = 0;
+                }
+            }
+        }
+
+        // Leave the best wave in the State (and its Solution)
+        if (state.calculateScore() < bestScore - 1e-9) {
+            state.orderSolution = best.mOrders;
+            state.aisleSolution = best.mAisles;
+            state.reset();
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include "common.hpp"
+#include "caches.hpp"
+
+namespace Tabu {
+    // Flips one aisle and repairs the wave around it: a closed aisle drops the
+    // orders left short and refills from its neighbours, an opened one packs
+    // what it now makes fit and lets redundant aisles go.
+    template<typename L>
+    bool flip(const Caches<L> &c, State<L> &state, int aisleIdx) {
+        if (state.aisleSelected[aisleIdx]) {
+            state.removeAisle(aisleIdx);
+            state.dropOrdersToRepairSolution();
+            for (int a : c.similarity.similarAisles(aisleIdx, 2))
+                if (state.aisleSelected[a]) state.packOrdersFromAisle(a);
+        } else {
+            state.addAisle(aisleIdx);
+            state.packOrdersFromAisle(aisleIdx);
+            state.pruneAislesToFitOrders();
+        }
+        return state.isFeasible();
+    }
+
+    // Candidate flips: a few visited aisles to close, and unvisited aisles to
+    // open picked by gain among a random sample plus neighbours of the wave.
+    template<typename L>
+    vector<int> candidates(const Problem &p, const Caches<L> &c, const State<L> &state, mt19937 &rng) {
+        const size_t CLOSE = 6, OPEN = 6, SAMPLE = 24;
+
+        vector<int> result;
+        vector<int> visited(state.aisleSolution.begin(), state.aisleSolution.end());
+        std::shuffle(visited.begin(), visited.end(), rng);
+        for (size_t i = 0; i < visited.size() && i < CLOSE; i += 1) result.push_back(visited[i]);
+
+        vector<pair<ll, int>> open;
+        for (size_t i = 0; i < SAMPLE; i += 1) {
+            int a = uniform_int_distribution<>(0, p.aisles.size() - 1)(rng);
+            if (!state.aisleSelected[a]) open.push_back({state.gainOfAisle(a), a});
+        }
+        if (!visited.empty())
+            for (int a : c.similarity.similarAisles(visited[0], OPEN))
+                if (!state.aisleSelected[a]) open.push_back({state.gainOfAisle(a), a});
+        std::sort(open.rbegin(), open.rend());
+        open.erase(std::unique(open.begin(), open.end()), open.end());
+        for (size_t i = 0; i < open.size() && i < OPEN; i += 1) result.push_back(open[i].second);
+        return result;
+    }
+
+    // Tabu search over aisle flips. Every candidate is tried on the live State
+    // under a journal checkpoint and rolled back; the best admissible one is
+    // applied. A flipped aisle stays tabu for a random tenure unless the move
+    // beats the best wave (aspiration), and aisles flipped often pay a
+    // frequency penalty so the search keeps moving into new regions.
+    template<typename L>
+    void search(const Problem &p, const Caches<L> &c, State<L> &state) {
+        static thread_local std::mt19937 rng(Seed::next());
+
+        const int MAX_ITERATIONS = 5000;
+        const int MAX_NON_IMPROVING = 400;
+        const int TENURE_MIN = 7;
+        const int TENURE_SPREAD = max<int>(1, sqrt((double)p.aisles.size()));
+        const double FREQUENCY_WEIGHT = 0.05;
+
+        if (!state.isFeasible() || p.aisles.empty()) return;
+
+        Solution best;
+        best.mOrders = state.orderSolution;
+        best.mAisles = state.aisleSolution;
+        double bestScore = state.calculateScore();
+
+        vector<int> tabuUntil(p.aisles.size(), 0), frequency(p.aisles.size(), 0);
+
+        int nonImproving = 0;
+        for (int iteration = 1; iteration <= MAX_ITERATIONS && nonImproving < MAX_NON_IMPROVING; iteration += 1) {
+            int chosen = -1;
+            double chosenValue = -1e18;
+            for (int a : candidates(p, c, state, rng)) {
+                size_t mark = state.checkpoint();
+                bool feasible = flip(c, state, a);
+                double score = state.calculateScore();
+                state.rollback(mark);
+                if (!feasible) continue;
+
+                bool aspiration = score > bestScore + 1e-9;
+                if (tabuUntil[a] > iteration && !aspiration) continue;
+
+                double value = aspiration ? score : score - FREQUENCY_WEIGHT * bestScore * frequency[a] / iteration;
+                if (value > chosenValue) {
+                    chosenValue = value;
+                    chosen = a;
+                }
+            }
+
+            nonImproving += 1;
+            if (chosen == -1) continue;
+
+            // Apply it for real; the repair may pick differently than the trial
+            size_t mark = state.checkpoint();
+            if (!flip(c, state, chosen)) {
+                state.rollback(mark);
+                continue;
+            }
+            state.commit(mark);
+            tabuUntil[chosen] = iteration + TENURE_MIN + uniform_int_distribution<>(0, TENURE_SPREAD)(rng);
+            frequency[chosen] += 1;
+
+            double score = state.calculateScore();
+            if (score > bestScore + 1e-9) {
+                bestScore = score;
+                best.mOrders = state.orderSolution;
+                best.mAisles = state.aisleSolution;
+                nonImproving = 0;
+            }
+        }
+
+        // Leave the best wave in the State (and its Solution)
+        if (state.calculateScore() < bestScore - 1e-9) {
+            state.orderSolution = best.mOrders;
+            state.aisleSolution = best.mAisles;
+            state.reset();
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <fstream>
+
+/**
+ * PARAMETERS
+ * The hand-picked constants of the constructions, of the refinement and of
+ * the driver, in one struct. A file of `key = value` lines (# starts a
+ * comment) overrides any of them; keys are the names in visit(). Heuristic 1
+ * starts from the preset of the instance's size class, tuned by tune.py for
+ * time to target on the datasets; the other heuristics from the defaults.
+ */
+struct Params {
+    double alphaGreedy = 0.3;       // Heur1: RCL band, share of the cost range
+    double alphaCached = 0.5;       // HeurCached construction: RCL band
+    int rclSize = 16;               // HeurCached construction: orders in the RCL
+    double alphaSampled = 0.5;      // Heur3/Heur4: RCL band over the sample
+    int sampleMin = 16;             // Heur3/Heur4: sample when scores are close
+    int sampleMax = 80;             // Heur3/Heur4: sample when scores spread
+    double spreadFull = 0.5;        // Heur3/Heur4: log score spread for the full sample
+    int aisleCandidates = 16;       // Refinement ADD: aisles looked at per step
+    int similarAisles = 8;          // Refinement ADD: of those, neighbours of a visited aisle
+    double perturbShare = 0.2;      // Warm restarts: share of orders dropped
+    double patience = 3.0;          // Seconds without a new best before stopping
+
+    chrono::milliseconds patienceTime() const {
+        return chrono::milliseconds((long long)(patience * 1000));
+    }
+
+    template<typename Self, typename F>
+    static void visit(Self &self, F f) {
+        f("alpha_greedy", self.alphaGreedy);
+        f("alpha_cached", self.alphaCached);
+        f("rcl_size", self.rclSize);
+        f("alpha_sampled", self.alphaSampled);
+        f("sample_min", self.sampleMin);
+        f("sample_max", self.sampleMax);
+        f("spread_full", self.spreadFull);
+        f("aisle_candidates", self.aisleCandidates);
+        f("similar_aisles", self.similarAisles);
+        f("perturb_share", self.perturbShare);
+        f("patience", self.patience);
+    }
+
+    // False for an unknown key or a value that does not parse
+    bool set(const std::string &key, const std::string &value) {
+        bool found = false, ok = true;
+        visit(*this, [&](const char *name, auto &field) {
+            if (key != name) return;
+            found = true;
+            std::istringstream in(value);
+            ok = bool(in >> field);
+        });
+        return found && ok;
+    }
+
+    void write(std::ostream &out) const {
+        visit(*this, [&](const char *name, const auto &field) { out << name << " = " << field << '\n'; });
+    }
+
+    // Keys in the file override `params`; the rest keep their values
+    static bool load(const std::string &path, Params &params) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Cannot read parameters " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        for (int number = 1; std::getline(in, line); number += 1) {
+            line = line.substr(0, line.find('#'));
+            size_t eq = line.find('=');
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            auto trim = [](std::string s) {
+                size_t b = s.find_first_not_of(" \t\r"), e = s.find_last_not_of(" \t\r");
+                return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+            };
+            if (eq == std::string::npos || !params.set(trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) {
+                std::cerr << path << ":" << number << ": bad parameter line '" << line << "'" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Size classes as tune.py races them: up to 1k orders, up to 10k, above.
+    // Raced for heuristic 1 only (8 candidates, 600 s per class, target 90%
+    // of best_objective), so the others keep the defaults. No candidate beat
+    // the defaults on the small class, where the exact solver settles most
+    // instances. Patience is not raced: time to target cannot see what a
+    // shorter one gives up, so it stays at the default.
+    static Params preset(size_t orders, int heuristic) {
+        Params params;
+        if (heuristic != 1 || orders <= 1000) return params;
+        if (orders <= 10000) {
+            params.alphaCached = 0.648;
+            params.rclSize = 41;
+            params.aisleCandidates = 41;
+            params.similarAisles = 12;
+        } else {
+            params.alphaCached = 0.581;
+            params.rclSize = 24;
+            params.aisleCandidates = 22;
+            params.similarAisles = 2;
+        }
+        return params;
+    }
+};
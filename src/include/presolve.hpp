@@ -0,0 +1,170 @@
+#pragma once
+
+#include "common.hpp"
+
+/**
+ * PRESOLVE
+ * Shrinks the instance before Caches are built: orders the whole warehouse
+ * cannot supply or that alone exceed ub are dropped, items nobody asks for
+ * are dropped from the aisles, and aisles left with nothing useful go away.
+ * Survivors are renumbered, and the IdMap takes a solution of the reduced
+ * instance back to the original ids.
+ *
+ * Identical orders are renumbered next to each other and counted; each keeps
+ * its own id, so restoring a solution needs no grouping.
+ * Dominated aisles are only counted: a wave may need both the aisle and the
+ * one that dominates it, so dropping them is not safe.
+ */
+namespace Presolve {
+    struct IdMap {
+        vector<int> orders, aisles;  // reduced id -> original id
+
+        static IdMap Identity(const Problem &p) {
+            IdMap map;
+            map.orders.resize(p.orders.size());
+            map.aisles.resize(p.aisles.size());
+            iota(map.orders.begin(), map.orders.end(), 0);
+            iota(map.aisles.begin(), map.aisles.end(), 0);
+            return map;
+        }
+
+        // Map from the ids of an instance derived once more from this one
+        IdMap compose(const IdMap &inner) const {
+            IdMap map;
+            for (int o : inner.orders) map.orders.pb(orders[o]);
+            for (int a : inner.aisles) map.aisles.pb(aisles[a]);
+            return map;
+        }
+
+        // The other way round: original ids that did not survive are dropped
+        Solution reduce(const Solution &original) const {
+            std::unordered_map<int, int> orderId, aisleId;
+            for (size_t o = 0; o < orders.size(); o += 1) orderId[orders[o]] = o;
+            for (size_t a = 0; a < aisles.size(); a += 1) aisleId[aisles[a]] = a;
+
+            Solution reduced;
+            for (int o : original.mOrders)
+                if (orderId.count(o)) reduced.mOrders.insert(orderId[o]);
+            for (int a : original.mAisles)
+                if (aisleId.count(a)) reduced.mAisles.insert(aisleId[a]);
+            return reduced;
+        }
+
+        Solution restore(const Solution &reduced) const {
+            Solution original;
+            for (int o : reduced.mOrders) original.mOrders.insert(orders[o]);
+            for (int a : reduced.mAisles) original.mAisles.insert(aisles[a]);
+            return original;
+        }
+    };
+
+    struct Stats {
+        size_t unservableOrders = 0, oversizedOrders = 0, unusedItems = 0, uselessAisles = 0;
+        size_t duplicateOrders = 0, dominatedAisles = 0;
+    };
+
+    struct Reduced {
+        Problem problem;
+        IdMap map;
+        Stats stats;
+    };
+
+    // Aisles whose stock is covered, item by item, by another aisle. Any
+    // such aisle also holds the first (biggest) line of the dominated one,
+    // which keeps the candidates few. Of equal aisles one is not counted.
+    size_t countDominated(const Problem &p) {
+        vector<vector<int>> aislesWith(p.itemCount);
+        for (size_t a = 0; a < p.aisles.size(); a += 1)
+            for (const auto &line : p.aisles[a]) aislesWith[line.ff].pb(a);
+
+        vector<ll> row(p.itemCount, 0);
+        size_t dominated = 0;
+        for (size_t a = 0; a < p.aisles.size(); a += 1) {
+            bool found = false;
+            for (int b : aislesWith[p.aisles[a][0].ff]) {
+                if (b == (int)a || p.aisles[b].size() < p.aisles[a].size()) continue;
+                for (const auto &line : p.aisles[b]) row[line.ff] = line.ss;
+                bool covered = true, equal = p.aisles[b].size() == p.aisles[a].size();
+                for (const auto &line : p.aisles[a]) {
+                    covered = covered && row[line.ff] >= line.ss;
+                    equal = equal && row[line.ff] == line.ss;
+                }
+                for (const auto &line : p.aisles[b]) row[line.ff] = 0;
+                if (covered && (!equal || b < (int)a)) { found = true; break; }
+            }
+            dominated += found;
+        }
+        return dominated;
+    }
+
+    Reduced reduce(const Problem &p) {
+        Reduced r;
+        Stats &stats = r.stats;
+
+        vector<ll> available(p.itemCount, 0);
+        for (const auto &aisle : p.aisles)
+            for (const auto &line : aisle)
+                if (line.ff < p.itemCount) available[line.ff] += line.ss;
+
+        // 1. Orders that can ever be part of a wave
+        vector<int> keptOrders;
+        for (size_t o = 0; o < p.orders.size(); o += 1) {
+            ll units = 0;
+            bool servable = true;
+            for (const auto &line : p.orders[o]) {
+                units += line.ss;
+                if (line.ff >= p.itemCount || available[line.ff] < line.ss) servable = false;
+            }
+            if (!servable) stats.unservableOrders += 1;
+            else if (units > p.ub) stats.oversizedOrders += 1;
+            else keptOrders.pb(o);
+        }
+
+        // Identical orders end up next to each other
+        vector<vector<pair<int, int>>> byItem(p.orders.size());
+        for (int o : keptOrders) {
+            byItem[o] = p.orders[o];
+            std::sort(byItem[o].begin(), byItem[o].end());
+        }
+        std::stable_sort(keptOrders.begin(), keptOrders.end(), [&](int a, int b) { return byItem[a] < byItem[b]; });
+
+        // 2. Items still demanded, renumbered densely
+        vector<int> itemId(p.itemCount, -1);
+        int items = 0;
+        for (int o : keptOrders)
+            for (const auto &line : p.orders[o])
+                if (itemId[line.ff] == -1) itemId[line.ff] = items++;
+        stats.unusedItems = p.itemCount - items;
+
+        Problem &q = r.problem;
+        q.itemCount = items;
+        q.lb = p.lb;
+        q.ub = p.ub;
+
+        for (size_t i = 0; i < keptOrders.size(); i += 1) {
+            int o = keptOrders[i];
+            if (i > 0 && byItem[o] == byItem[keptOrders[i - 1]]) stats.duplicateOrders += 1;
+
+            vector<pair<int, int>> lines;
+            for (const auto &line : p.orders[o]) lines.pb({itemId[line.ff], line.ss});
+            q.orders.pb(lines);
+            r.map.orders.pb(o);
+        }
+
+        // 3. Aisles that hold at least one demanded item
+        for (size_t a = 0; a < p.aisles.size(); a += 1) {
+            vector<pair<int, int>> lines;
+            for (const auto &line : p.aisles[a])
+                if (line.ff < p.itemCount && itemId[line.ff] != -1) lines.pb({itemId[line.ff], line.ss});
+            if (lines.empty()) {
+                stats.uselessAisles += 1;
+                continue;
+            }
+            q.aisles.pb(lines);
+            r.map.aisles.pb(a);
+        }
+
+        stats.dominatedAisles = countDominated(q);
+        return r;
+    }
+}
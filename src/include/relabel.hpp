@@ -0,0 +1,119 @@
+#pragma once
+
+#include "common.hpp"
+#include "presolve.hpp"
+
+#include <queue>
+
+/**
+ * RELABELING
+ * Item ids come straight from the file, so the lines of one order touch
+ * itemBalance all over memory. This pass renumbers items and orders in
+ * reverse Cuthill-McKee order over the bipartite order-item graph: a BFS
+ * from a low-degree item, neighbours by increasing degree, labels reversed.
+ * Items of the same order get nearby ids, and orders sharing items sit
+ * close in itemToOrders. Aisles follow the new id of their biggest line.
+ */
+namespace Relabel {
+    struct Relabeled {
+        Problem problem;
+        Presolve::IdMap map;
+    };
+
+    Relabeled apply(const Problem &p) {
+        size_t items = p.itemCount, orders = p.orders.size();
+
+        vector<vector<int>> ordersWith(items);
+        for (size_t o = 0; o < orders; o += 1)
+            for (const auto &line : p.orders[o]) ordersWith[line.ff].pb(o);
+
+        auto byDegree = [&](vector<int> &nodes, bool item) {
+            std::sort(nodes.begin(), nodes.end(), [&](int a, int b) {
+                size_t da = item ? ordersWith[a].size() : p.orders[a].size();
+                size_t db = item ? ordersWith[b].size() : p.orders[b].size();
+                return da != db ? da < db : a < b;
+            });
+        };
+
+        vector<int> startItems;
+        for (size_t i = 0; i < items; i += 1)
+            if (!ordersWith[i].empty()) startItems.pb(i);
+        byDegree(startItems, true);
+
+        // BFS with items as (id) and orders as (-1 - id)
+        vector<bool> itemSeen(items, false), orderSeen(orders, false);
+        vector<int> itemOrder, orderOrder, next;
+        std::queue<int> queue;
+        for (int start : startItems) {
+            if (itemSeen[start]) continue;
+            itemSeen[start] = true;
+            queue.push(start);
+            while (!queue.empty()) {
+                int node = queue.front();
+                queue.pop();
+                next.clear();
+                if (node >= 0) {
+                    itemOrder.pb(node);
+                    for (int o : ordersWith[node])
+                        if (!orderSeen[o]) { orderSeen[o] = true; next.pb(o); }
+                    byDegree(next, false);
+                    for (int o : next) queue.push(-1 - o);
+                } else {
+                    int o = -1 - node;
+                    orderOrder.pb(o);
+                    for (const auto &line : p.orders[o])
+                        if (!itemSeen[line.ff]) { itemSeen[line.ff] = true; next.pb(line.ff); }
+                    byDegree(next, true);
+                    for (int i : next) queue.push(i);
+                }
+            }
+        }
+        std::reverse(itemOrder.begin(), itemOrder.end());
+        std::reverse(orderOrder.begin(), orderOrder.end());
+
+        // Items nobody orders and orders without lines go last
+        for (size_t i = 0; i < items; i += 1)
+            if (!itemSeen[i]) itemOrder.pb(i);
+        for (size_t o = 0; o < orders; o += 1)
+            if (!orderSeen[o]) orderOrder.pb(o);
+
+        vector<int> itemId(items);
+        for (size_t i = 0; i < items; i += 1) itemId[itemOrder[i]] = i;
+
+        // Lines keep the biggest-first order, nearby ids first on ties
+        auto relabel = [&](const vector<pair<int, int>> &lines) {
+            vector<pair<int, int>> result;
+            for (const auto &line : lines) result.pb({itemId[line.ff], line.ss});
+            std::sort(result.begin(), result.end(), [](auto &a, auto &b) {
+                return a.ss != b.ss ? a.ss > b.ss : a.ff < b.ff;
+            });
+            return result;
+        };
+
+        Relabeled r;
+        Problem &q = r.problem;
+        q.itemCount = p.itemCount;
+        q.lb = p.lb;
+        q.ub = p.ub;
+
+        for (int o : orderOrder) {
+            q.orders.pb(relabel(p.orders[o]));
+            r.map.orders.pb(o);
+        }
+
+        vector<vector<pair<int, int>>> aisles;
+        for (const auto &aisle : p.aisles) aisles.pb(relabel(aisle));
+        vector<int> aisleOrder(p.aisles.size());
+        iota(aisleOrder.begin(), aisleOrder.end(), 0);
+        std::sort(aisleOrder.begin(), aisleOrder.end(), [&](int a, int b) {
+            int ka = aisles[a].empty() ? INT_MAX : aisles[a][0].ff;
+            int kb = aisles[b].empty() ? INT_MAX : aisles[b][0].ff;
+            return ka != kb ? ka < kb : a < b;
+        });
+        for (int a : aisleOrder) {
+            q.aisles.pb(aisles[a]);
+            r.map.aisles.pb(a);
+        }
+        return r;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "common.hpp"
+
+/**
+ * WEIGHTED SAMPLER
+ * Fenwick tree over non-negative weights: set() and sample() are O(log n),
+ * so a construction can keep one weight per candidate current as the state
+ * moves and draw proportionally to it. A zero weight takes the candidate
+ * out, and emptiness is an exact count of positive weights. Updates are
+ * deltas in floating point, so the tree is rebuilt from the plain weights
+ * every n updates to keep the drift bounded.
+ */
+namespace Sampler {
+    class Fenwick {
+        vector<double> tree, weights;
+        double sum = 0.0;
+        size_t updates = 0, positive = 0;
+        int topBit = 0;
+
+        void rebuild() {
+            size_t n = weights.size();
+            std::fill(tree.begin(), tree.end(), 0.0);
+            sum = 0.0;
+            positive = 0;
+            for (size_t i = 1; i <= n; i += 1) {
+                positive += weights[i - 1] > 0;
+                tree[i] += weights[i - 1];
+                sum += weights[i - 1];
+                size_t parent = i + (i & -i);
+                if (parent <= n) tree[parent] += tree[i];
+            }
+            updates = 0;
+        }
+
+    public:
+        explicit Fenwick(const vector<double> &initial = {}) { assign(initial); }
+
+        void assign(const vector<double> &initial) {
+            weights = initial;
+            tree.assign(weights.size() + 1, 0.0);
+            topBit = 1;
+            while ((size_t)topBit * 2 <= weights.size()) topBit *= 2;
+            rebuild();
+        }
+
+        size_t size() const { return weights.size(); }
+        double weight(int i) const { return weights[i]; }
+        double total() const { return sum; }
+        bool empty() const { return positive == 0; }
+
+        void set(int i, double w) {
+            double delta = w - weights[i];
+            if (delta == 0.0) return;
+            positive += (w > 0) - (weights[i] > 0);
+            weights[i] = w;
+            if (++updates >= weights.size()) {
+                rebuild();
+                return;
+            }
+            sum += delta;
+            for (size_t j = i + 1; j < tree.size(); j += j & -j) tree[j] += delta;
+            if (positive > 0 && sum <= 0) rebuild();
+        }
+
+        // Index drawn with probability weight / total, -1 when all are zero.
+        // Rounding can land on a zero weight next to the target; callers skip it.
+        template<typename RNG>
+        int sample(RNG &rng) const {
+            if (empty()) return -1;
+            double target = std::uniform_real_distribution<double>(0.0, sum)(rng);
+            size_t pos = 0;
+            for (size_t bit = topBit; bit > 0; bit >>= 1) {
+                if (pos + bit < tree.size() && tree[pos + bit] <= target) {
+                    pos += bit;
+                    target -= tree[pos];
+                }
+            }
+            return (int)min(pos, weights.size() - 1);
+        }
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "common.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCREEN_X86_AVX2 1
+#endif
+
+/**
+ * ORDER SCREENING KERNELS
+ * Finds the lines whose item balance is below the quantity, over a run of
+ * the flat line arrays in Caches, and writes their positions to `found`
+ * (which needs room for n + PADDING entries). Both kernels are branchless
+ * per line. The AVX2 one gathers eight balances per step and left-packs
+ * the short positions with a permute; it is picked at run time when the
+ * CPU has AVX2 and pays off on long runs (a whole-instance pass), while
+ * the scalar one is better for the few lines of a single order.
+ */
+namespace Screen {
+    const int PADDING = 8;
+
+    template<typename Balance>
+    int shortLinesScalar(const Balance *balance, const int32_t *items, const int32_t *qty, int n, int32_t *found) {
+        int count = 0;
+        for (int i = 0; i < n; i += 1) {
+            found[count] = i;
+            count += balance[items[i]] < qty[i];
+        }
+        return count;
+    }
+
+#ifdef SCREEN_X86_AVX2
+    // Lane permutations that move the set lanes of a mask to the front
+    struct PackTable {
+        int32_t lanes[256][8];
+        PackTable() {
+            for (int mask = 0; mask < 256; mask += 1) {
+                int k = 0;
+                for (int b = 0; b < 8; b += 1)
+                    if (mask >> b & 1) lanes[mask][k++] = b;
+                while (k < 8) lanes[mask][k++] = 0;
+            }
+        }
+    };
+
+    __attribute__((target("avx2")))
+    inline int shortLinesAvx2(const int32_t *balance, const int32_t *items, const int32_t *qty, int n, int32_t *found) {
+        static const PackTable pack;
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        int count = 0;
+        for (int base = 0; base < n; base += 8) {
+            __m256i idx = _mm256_loadu_si256((const __m256i *)(items + base));
+            __m256i need = _mm256_loadu_si256((const __m256i *)(qty + base));
+            __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - base), lane);
+            __m256i have = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)balance, idx, valid, 4);
+            __m256i lacking = _mm256_and_si256(_mm256_cmpgt_epi32(need, have), valid);
+            unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(lacking));
+
+            __m256i order = _mm256_loadu_si256((const __m256i *)pack.lanes[mask]);
+            __m256i positions = _mm256_add_epi32(_mm256_set1_epi32(base), lane);
+            _mm256_storeu_si256((__m256i *)(found + count), _mm256_permutevar8x32_epi32(positions, order));
+            count += __builtin_popcount(mask);
+        }
+        return count;
+    }
+#endif
+
+    inline int shortLines(const int32_t *balance, const int32_t *items, const int32_t *qty, int n, int32_t *found) {
+#ifdef SCREEN_X86_AVX2
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2) return shortLinesAvx2(balance, items, qty, n, found);
+#endif
+        return shortLinesScalar(balance, items, qty, n, found);
+    }
+
+    inline int shortLines(const ll *balance, const int32_t *items, const int32_t *qty, int n, int32_t *found) {
+        return shortLinesScalar(balance, items, qty, n, found);
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "common.hpp"
+#include <array>
+
+/**
+ * SIMILARITY INDEX
+ * MinHash signatures of the item set of every order and aisle, with LSH
+ * band buckets so "which aisles/orders look like this one" costs a few
+ * bucket lookups instead of walking itemToOrders for every shared item.
+ * Built once next to Caches, read-only afterwards.
+ */
+struct SimilarityIndex {
+    static constexpr int BANDS = 8;
+    static constexpr int ROWS = 2;                 // Jaccard 0.3 -> ~50% recall, 0.6 -> ~97%
+    static constexpr int HASHES = BANDS * ROWS;
+    static constexpr size_t BUCKET_SCAN = 64;      // Popular items make huge buckets; only look at the head
+
+    typedef std::array<uint32_t, HASHES> Signature;
+
+    vector<Signature> orderSig, aisleSig;
+    vector<unordered_map<uint64_t, vector<int>>> orderBuckets, aisleBuckets;
+
+    static Signature sign(const vector<pair<int, int>> &lines) {
+        Signature sig;
+        sig.fill(UINT32_MAX);
+        for (const auto &line : lines)
+            for (int h = 0; h < HASHES; h += 1)
+                sig[h] = min<uint32_t>(sig[h], (uint32_t)mix64(((uint64_t)h << 32) | (uint32_t)line.ff));
+        return sig;
+    }
+
+    static uint64_t bandKey(const Signature &sig, int band) {
+        uint64_t key = band;
+        for (int r = 0; r < ROWS; r += 1) key = mix64(key ^ sig[band * ROWS + r]);
+        return key;
+    }
+
+    // Fraction of equal MinHashes, an unbiased estimate of the Jaccard index
+    static double similarity(const Signature &a, const Signature &b) {
+        int equal = 0;
+        for (int h = 0; h < HASHES; h += 1) equal += (a[h] == b[h]);
+        return (double)equal / HASHES;
+    }
+
+    static void bucketize(const vector<Signature> &sigs, const vector<vector<pair<int, int>>> &sets,
+                          vector<unordered_map<uint64_t, vector<int>>> &buckets) {
+        buckets.assign(BANDS, {});
+        for (size_t i = 0; i < sigs.size(); i += 1) {
+            if (sets[i].empty()) continue;
+            for (int b = 0; b < BANDS; b += 1) buckets[b][bandKey(sigs[i], b)].pb(i);
+        }
+    }
+
+    void build(const Problem &p) {
+        orderSig.resize(p.orders.size());
+        aisleSig.resize(p.aisles.size());
+        for (size_t o = 0; o < p.orders.size(); o += 1) orderSig[o] = sign(p.orders[o]);
+        for (size_t a = 0; a < p.aisles.size(); a += 1) aisleSig[a] = sign(p.aisles[a]);
+        bucketize(orderSig, p.orders, orderBuckets);
+        bucketize(aisleSig, p.aisles, aisleBuckets);
+    }
+
+    // Re-signs entry i after its item set changed and moves it between buckets
+    static void resign(size_t i, const vector<pair<int, int>> &lines, vector<Signature> &sigs,
+                       vector<unordered_map<uint64_t, vector<int>>> &buckets) {
+        if (i < sigs.size()) {
+            for (int b = 0; b < BANDS; b += 1) {
+                auto it = buckets[b].find(bandKey(sigs[i], b));
+                if (it == buckets[b].end()) continue;
+                auto &bucket = it->ss;
+                bucket.erase(std::remove(bucket.begin(), bucket.end(), (int)i), bucket.end());
+                if (bucket.empty()) buckets[b].erase(it);
+            }
+        } else {
+            sigs.resize(i + 1);
+        }
+        sigs[i] = sign(lines);
+        if (lines.empty()) return;
+        for (int b = 0; b < BANDS; b += 1) buckets[b][bandKey(sigs[i], b)].pb(i);
+    }
+
+    void updateOrder(int order, const vector<pair<int, int>> &lines) { resign(order, lines, orderSig, orderBuckets); }
+    void updateAisle(int aisle, const vector<pair<int, int>> &lines) { resign(aisle, lines, aisleSig, aisleBuckets); }
+
+    // Top-k entries of `buckets` most similar to `sig`, skipping `self`
+    static vector<int> query(const Signature &sig, const vector<Signature> &sigs,
+                             const vector<unordered_map<uint64_t, vector<int>>> &buckets, int self, size_t k) {
+        vector<pair<double, int>> found;
+        for (int b = 0; b < BANDS; b += 1) {
+            auto it = buckets[b].find(bandKey(sig, b));
+            if (it == buckets[b].end()) continue;
+            size_t scanned = 0;
+            for (int other : it->ss) {
+                if (scanned++ >= BUCKET_SCAN) break;
+                if (other != self) found.pb({similarity(sig, sigs[other]), other});
+            }
+        }
+        std::sort(found.begin(), found.end(), [](auto &x, auto &y) {
+            return x.ff != y.ff ? x.ff > y.ff : x.ss < y.ss;
+        });
+        vector<int> result;
+        for (size_t i = 0; i < found.size() && result.size() < k; i += 1)
+            if (i == 0 || found[i].ss != found[i - 1].ss) result.pb(found[i].ss);
+        return result;
+    }
+
+    vector<int> similarAisles(int aisle, size_t k) const { return query(aisleSig[aisle], aisleSig, aisleBuckets, aisle, k); }
+    vector<int> similarOrders(int order, size_t k) const { return query(orderSig[order], orderSig, orderBuckets, order, k); }
+
+    // Aisles whose stock looks like the order's item set
+    vector<int> aislesForOrder(int order, size_t k) const { return query(orderSig[order], aisleSig, aisleBuckets, -1, k); }
+};
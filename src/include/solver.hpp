@@ -0,0 +1,458 @@
+#pragma once
+
+#include "common.hpp"
+#include "caches.hpp"
+#include "heuristic1.cpp"
+#include "heuristic2.cpp"
+#include "heuristic3.cpp"
+#include "heuristic4.cpp"
+#include "heuristic5.cpp"
+#include "heuristic6.cpp"
+#include "sweep.hpp"
+#include "exact.hpp"
+#include "presolve.hpp"
+#include "relabel.hpp"
+#include "trace.hpp"
+#include "team.hpp"
+#include "params.hpp"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <memory>
+
+/**
+ * MULTI-START DRIVER
+ * Runs the chosen heuristic on several threads until no thread improves the
+ * incumbent for `params.patience`. Shared by the single-instance solver and the
+ * batch runner, which runs many of these at once with a few threads each.
+ */
+namespace Solver {
+    // What a solve reports beyond the solution; filled in when Config::stats is set
+    struct Stats {
+        size_t coldRuns = 0;      // Runs that asked the duplicate cache
+        size_t skippedRuns = 0;   // Of those, runs whose aisle set was already refined
+    };
+
+    struct Config {
+        int heuristic = 1;
+        size_t threadCount = 0; // 0 = all hardware threads
+        Params params;          // Constants of the heuristics and the patience
+        std::string logPath = "";
+        bool verbose = true;
+        bool exact = true;      // Try the exact solver first on small instances
+        bool presolve = true;   // Solve the reduced instance, answer in original ids
+        bool relabel = false;   // Renumber items, orders and aisles for locality
+        bool verify = false;    // Cross-check every certificate with the full feasibility check
+        Solution warmStart;     // Wave to restart from, in the ids of the instance being solved
+        size_t teamSize = 1;    // Threads sharing one trajectory's refinement; restarts get the rest
+        size_t dedupSlots = 1 << 16; // Aisle sets remembered as refined; 0 refines every run
+        Stats *stats = nullptr; // Where to report the run counts, if anywhere
+    };
+
+    // Not a per-thread heuristic: splits the aisle counts across threads
+    const int SWEEP = 6;
+
+    // A heuristic handed a non-empty solution skips construction and
+    // refines it: that is how warm-started runs enter the search
+    // The team, when there is one, belongs to the calling thread.
+    typedef std::function<Certificate(Solution&, const Trace::Probe&, Team*)> Heuristic;
+
+    // A construction ending on an aisle set some run already refined is
+    // returned as built: the refinement would retrace the same moves.
+    // Only cold runs ask: a perturbed restart keeps every aisle of the
+    // incumbent, so its aisle set is always one that was seen.
+    template<typename L>
+    bool explored(Dedup::Table *dedup, const State<L> &state, const Trace::Probe &probe) {
+        if (!dedup || dedup->claim(state.aisleHash)) return false;
+        probe(Trace::Phase::Skipped, state.currentTotalUnits, state.aisleSolution.size());
+        return true;
+    }
+
+    template<typename L>
+    Heuristic makeHeuristic(const Problem &p, const Caches<L> &c, int chosenHeuristic, const Params &params,
+                            Dedup::Table *dedup) {
+        switch(chosenHeuristic) {
+            case 0:
+                return [&p, &params](Solution &s, const Trace::Probe &probe, Team *) {
+                    if (s.mOrders.empty()) Heur1::construction(p, s, params);
+                    probe(Trace::Phase::Construction, s.getTotalUnits(p), s.mAisles.size());
+                    Heur1::refinement(p, s);
+                    return s.certify(p);
+                };
+            default:
+            case 1:
+                return [&p, &c, &params, dedup](Solution &s, const Trace::Probe &probe, Team *team) {
+                    const bool cold = s.mOrders.empty();
+                    State<L> state(p, c, s);
+                    if (cold) HeurCached::construction(p, c, state, params);
+                    probe(Trace::Phase::Construction, state.currentTotalUnits, state.aisleSolution.size());
+                    if (!(cold && explored(dedup, state, probe))) HeurCached::refinement(p, c, state, params, team);
+                    return state.certify();
+                };
+            case 2:
+                return [&p, &c, &params, dedup](Solution &s, const Trace::Probe &probe, Team *team) {
+                    const bool cold = s.mOrders.empty();
+                    State<L> state(p, c, s);
+                    if (cold) Heur3::construction(p, c, state, params);
+                    probe(Trace::Phase::Construction, state.currentTotalUnits, state.aisleSolution.size());
+                    if (!(cold && explored(dedup, state, probe))) HeurCached::refinement(p, c, state, params, team);
+                    return state.certify();
+                };
+            case 3:
+                return [&p, &c, &params, dedup](Solution &s, const Trace::Probe &probe, Team *team) {
+                    const bool cold = s.mOrders.empty();
+                    State<L> state(p, c, s);
+                    if (cold) Heur4::construction(p, c, state, params);
+                    probe(Trace::Phase::Construction, state.currentTotalUnits, state.aisleSolution.size());
+                    if (!(cold && explored(dedup, state, probe))) HeurCached::refinement(p, c, state, params, team);
+                    return state.certify();
+                };
+            case 4:
+                return [&p, &c, &params, dedup](Solution &s, const Trace::Probe &probe, Team *) {
+                    const bool cold = s.mOrders.empty();
+                    State<L> state(p, c, s);
+                    if (cold) Heur3::construction(p, c, state, params);
+                    probe(Trace::Phase::Construction, state.currentTotalUnits, state.aisleSolution.size());
+                    if (!(cold && explored(dedup, state, probe))) Alns::search(p, c, state, params);
+                    return state.certify();
+                };
+            case 5:
+                return [&p, &c, &params, dedup](Solution &s, const Trace::Probe &probe, Team *) {
+                    const bool cold = s.mOrders.empty();
+                    State<L> state(p, c, s);
+                    if (cold) Heur3::construction(p, c, state, params);
+                    probe(Trace::Phase::Construction, state.currentTotalUnits, state.aisleSolution.size());
+                    if (!(cold && explored(dedup, state, probe))) Tabu::search(p, c, state);
+                    return state.certify();
+                };
+        }
+    }
+
+    // A certificate that disagrees with the full recount is a bug in some
+    // incremental update; say so, but never let it into the incumbent.
+    bool verify(const Problem &p, const Solution &s, const Certificate &certificate) {
+        Certificate full = s.certify(p);
+        bool agrees = full.feasible == certificate.feasible && full.units == certificate.units
+            && full.aisles == certificate.aisles;
+        if (!agrees) {
+            std::cerr << "Certificate mismatch: " << certificate.units << " units, " << certificate.aisles << " aisles, "
+                << (certificate.feasible ? "feasible" : "unfeasible") << " claimed; " << full.units << ", "
+                << full.aisles << ", " << (full.feasible ? "feasible" : "unfeasible") << " found" << std::endl;
+        }
+        return agrees;
+    }
+
+    // Full check, paid only by a solution about to become the incumbent
+    bool confirm(const Problem &p, const Solution &s, const Certificate &certificate) {
+        if (s.checkFeasibility(p)) return true;
+        verify(p, s, certificate);
+        return false;
+    }
+
+    // Drops about `share` of the orders; refinement refills the wave
+    Solution perturb(const Solution &s, double share, mt19937 &rng) {
+        Solution result = s;
+        std::bernoulli_distribution drop(share);
+        for (int o : s.mOrders)
+            if (drop(rng)) result.mOrders.erase(o);
+        return result;
+    }
+
+    // A warm start from a changed snapshot may be short of some items: it
+    // loses the orders drawing on them and refills from its own aisles, so
+    // the aisle set that made it good survives
+    template<typename L>
+    Solution prepareWarmStart(const Problem &p, const Caches<L> &c, const Config &config) {
+        Solution warmStart = config.warmStart;
+        if (warmStart.mOrders.empty()) return warmStart;
+
+        Certificate certificate = warmStart.certify(p);
+        if (!certificate.feasible) {
+            State<L> state(p, c, warmStart);
+            state.dropOrdersToRepairSolution();
+            vector<int> aisles(state.aisleSolution.begin(), state.aisleSolution.end());
+            for (int a : aisles) state.packOrdersFromAisle(a);
+            state.pruneAislesToFitOrders();
+            if (config.verbose)
+                std::cerr << "Warm start: " << certificate.score() << " Unfeasible, repaired to "
+                    << state.calculateScore() << (state.isFeasible() ? " Feasible" : " Unfeasible") << std::endl;
+        } else if (config.verbose) {
+            std::cerr << "Warm start: " << certificate.score() << " Feasible" << std::endl;
+        }
+        return warmStart;
+    }
+
+    // A feasible warm start is the first incumbent
+    void seedIncumbent(const Problem &p, const Solution &warmStart, Solution &bestSolution, double &bestScore) {
+        if (warmStart.mOrders.empty()) return;
+        Certificate certificate = warmStart.certify(p);
+        if (!certificate.feasible) return;
+        bestSolution = warmStart;
+        bestScore = certificate.score();
+    }
+
+    template<typename L>
+    Solution run(const Problem &p, const Caches<L> &c, const Config &config) {
+        std::unique_ptr<Dedup::Table> dedup;
+        if (config.dedupSlots > 0) dedup = std::make_unique<Dedup::Table>(config.dedupSlots);
+        auto heuristic = makeHeuristic(p, c, config.heuristic, config.params, dedup.get());
+
+        size_t threadCount = config.threadCount;
+        if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+        // Each restart thread leads a team of teamSize threads
+        const size_t teamSize = max<size_t>(1, config.teamSize);
+        threadCount = max<size_t>(1, threadCount / teamSize);
+
+        // Marca o tempo de início total
+        auto startTime = chrono::high_resolution_clock::now();
+        auto lastImprovement = startTime;
+
+        // Only the trace's own thread writes to the log file
+        std::unique_ptr<Trace::Writer> trace;
+        if (!config.logPath.empty()) trace = std::make_unique<Trace::Writer>(config.logPath, threadCount);
+
+        std::vector<std::thread> threads;
+
+        mutex solutionMutex;
+        Solution bestSolution;
+        double bestScore = 0.0;
+        const Solution warmStart = prepareWarmStart(p, c, config);
+        seedIncumbent(p, warmStart, bestSolution, bestScore);
+        bool warm = !warmStart.mOrders.empty();
+
+        threads.reserve(threadCount);
+        for(size_t threadIndex = 0; threadIndex < threadCount; threadIndex += 1) {
+            threads.emplace_back([&, threadIndex] {
+                Trace::Probe probe;
+                if (trace) probe.ring = trace->ring(threadIndex);
+                probe.thread = threadIndex;
+                probe.heuristic = config.heuristic;
+                probe.start = startTime;
+
+                mt19937 rng(Seed::next());
+                std::unique_ptr<Team> team;
+                if (teamSize > 1) team = std::make_unique<Team>(teamSize);
+
+                auto now = chrono::high_resolution_clock::now();
+                for (size_t iteration = 0; now < lastImprovement + config.params.patienceTime(); iteration += 1) {
+                    // With a warm start, every other run refines the incumbent
+                    // (the warm start itself, untouched, on the very first one)
+                    // after dropping some of its orders; the rest start empty
+                    Solution solution;
+                    if (warm && (threadIndex + iteration) % 2 == 0) {
+                        if (threadIndex == 0 && iteration == 0) solution = warmStart;
+                        else {
+                            solutionMutex.lock();
+                            Solution start = bestSolution.mOrders.empty() ? warmStart : bestSolution;
+                            solutionMutex.unlock();
+                            solution = perturb(start, config.params.perturbShare, rng);
+                        }
+                    }
+                    Certificate certificate = heuristic(solution, probe, team.get());
+                    probe(Trace::Phase::Refinement, certificate.units, certificate.aisles);
+                    if (config.verify) verify(p, solution, certificate);
+
+                    if(!certificate.feasible) {
+                        continue;
+                    }
+                    double score = certificate.score();
+
+                    solutionMutex.lock();
+                    now = chrono::high_resolution_clock::now();
+                    if (score > bestScore && confirm(p, solution, certificate)) {
+                        if (config.verbose)
+                            std::cerr << "New best! " << score << std::endl;
+
+                        bestScore = score;
+                        bestSolution = solution;
+                        lastImprovement = now;
+                        probe(Trace::Phase::Best, certificate.units, certificate.aisles);
+                    }
+                    solutionMutex.unlock();
+                }
+            });
+        }
+        for(auto &t: threads) t.join();
+
+        if (config.stats && dedup) {
+            config.stats->coldRuns = dedup->claimCount();
+            config.stats->skippedRuns = dedup->repeatCount();
+        }
+        if (config.verbose && dedup && dedup->claimCount() > 0)
+            std::cerr << "Duplicate aisle sets: skipped refinement on " << dedup->repeatCount() << " of "
+                << dedup->claimCount() << " runs ("
+                << (ll)(1000.0 * dedup->repeatCount() / dedup->claimCount() + 0.5) / 10.0 << "%)" << std::endl;
+
+        return bestSolution;
+    }
+
+    // Threads take aisle counts k from a shared counter, pass after pass with
+    // new random starts, and skip every k whose bound cannot beat the
+    // incumbent. The bound falls with k, so once the smallest k is pruned
+    // the incumbent is optimal and the sweep ends early.
+    template<typename L>
+    Solution sweep(const Problem &p, const Caches<L> &c, const Config &config) {
+        const Sweep::Bounds bounds(p, c);
+        const int span = max(1, bounds.kMax() - bounds.kMin + 1);
+
+        size_t threadCount = config.threadCount;
+        if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+
+        auto startTime = chrono::high_resolution_clock::now();
+        auto lastImprovement = startTime;
+
+        std::unique_ptr<Trace::Writer> trace;
+        if (!config.logPath.empty()) trace = std::make_unique<Trace::Writer>(config.logPath, threadCount);
+
+        std::vector<std::thread> threads;
+        std::atomic<ll> next{0};
+        std::atomic<bool> proven{false};
+
+        mutex solutionMutex;
+        Solution bestSolution;
+        double bestScore = 0.0;
+        seedIncumbent(p, prepareWarmStart(p, c, config), bestSolution, bestScore);
+
+        threads.reserve(threadCount);
+        for(size_t threadIndex = 0; threadIndex < threadCount; threadIndex += 1) {
+            threads.emplace_back([&, threadIndex] {
+                Trace::Probe probe;
+                if (trace) probe.ring = trace->ring(threadIndex);
+                probe.thread = threadIndex;
+                probe.heuristic = config.heuristic;
+                probe.start = startTime;
+
+                mt19937 rng(Seed::next());
+
+                auto now = chrono::high_resolution_clock::now();
+                while (!proven && now < lastImprovement + config.params.patienceTime()) {
+                    int k = bounds.kMin + (int)(next++ % span);
+
+                    solutionMutex.lock();
+                    double incumbent = bestScore;
+                    now = chrono::high_resolution_clock::now();
+                    solutionMutex.unlock();
+
+                    if (bounds.at(p, bounds.kMin) <= incumbent + 1e-9) {
+                        proven = true;
+                        break;
+                    }
+                    if (bounds.at(p, k) <= incumbent + 1e-9) continue;
+
+                    Solution solution;
+                    State<L> state(p, c, solution);
+                    Sweep::construction(p, c, state, k, rng);
+                    probe(Trace::Phase::Construction, state.currentTotalUnits, state.aisleSolution.size());
+                    Sweep::search(p, c, state, rng);
+                    state.pruneAislesToFitOrders();
+                    Certificate certificate = state.certify();
+                    probe(Trace::Phase::Refinement, certificate.units, certificate.aisles);
+                    if (config.verify) verify(p, solution, certificate);
+
+                    if (!certificate.feasible) continue;
+                    double score = certificate.score();
+
+                    solutionMutex.lock();
+                    now = chrono::high_resolution_clock::now();
+                    if (score > bestScore && confirm(p, solution, certificate)) {
+                        if (config.verbose)
+                            std::cerr << "New best! " << score << " with k = " << k << std::endl;
+
+                        bestScore = score;
+                        bestSolution = solution;
+                        lastImprovement = now;
+                        probe(Trace::Phase::Best, certificate.units, certificate.aisles);
+                    }
+                    solutionMutex.unlock();
+                }
+            });
+        }
+        for(auto &t: threads) t.join();
+
+        if (config.verbose && proven) std::cerr << "Sweep bound proves the incumbent optimal" << std::endl;
+        return bestSolution;
+    }
+
+    template<typename L>
+    Solution solveWith(const Problem &p, const Config &config) {
+        if (config.verbose) std::cerr << "Computing caches" << std::endl;
+        const Caches<L> c(p);
+
+        if (config.verbose) std::cerr << "Running threads" << std::endl;
+        if (config.heuristic == SWEEP) return sweep(p, c, config);
+        return run(p, c, config);
+    }
+
+    // Picks the narrowest index layout that fits the instance and runs the
+    // matching specialization of every cache-based heuristic.
+    Solution solveReduced(const Problem &p, const Config &config) {
+        Config heuristicConfig = config;
+        if (config.exact && Exact::applicable(p)) {
+            auto startTime = chrono::high_resolution_clock::now();
+            Exact::Result exact = Exact::solve(p);
+            if (exact.optimal) {
+                if (config.verbose) std::cerr << "Exact search proved the optimum in " << exact.nodes << " nodes" << std::endl;
+                if (!config.logPath.empty()) {
+                    Trace::Writer trace(config.logPath, 1);
+                    Trace::Probe probe;
+                    probe.ring = trace.ring(0);
+                    probe.heuristic = config.heuristic;
+                    probe.start = startTime;
+                    probe(Trace::Phase::Best, exact.solution.getTotalUnits(p), exact.solution.mAisles.size());
+                }
+                return exact.solution;
+            }
+            if (config.verbose) std::cerr << "Exact search gave up after " << exact.nodes << " nodes" << std::endl;
+
+            // Its incumbent is still a good wave: the heuristics start from
+            // it, unless the caller's warm start is better
+            Certificate found = exact.solution.certify(p), given = config.warmStart.certify(p);
+            if (found.feasible && (!given.feasible || found.score() > given.score()))
+                heuristicConfig.warmStart = exact.solution;
+        }
+
+        LayoutKind layout = chooseLayout(p);
+        if (config.verbose) std::cerr << "Using " << layoutName(layout) << " layout" << std::endl;
+
+        switch (layout) {
+            case LayoutKind::Small: return solveWith<SmallLayout>(p, heuristicConfig);
+            case LayoutKind::Medium: return solveWith<MediumLayout>(p, heuristicConfig);
+            default: return solveWith<WideLayout>(p, heuristicConfig);
+        }
+    }
+
+    Solution solve(const Problem &p, const Config &config) {
+        if (!config.presolve && !config.relabel) return solveReduced(p, config);
+
+        Presolve::Reduced reduced;
+        if (config.presolve) {
+            reduced = Presolve::reduce(p);
+            const auto &stats = reduced.stats;
+            if (config.verbose) {
+                std::cerr << "Presolve: " << reduced.problem.orders.size() << '/' << p.orders.size() << " orders, "
+                    << reduced.problem.aisles.size() << '/' << p.aisles.size() << " aisles, "
+                    << reduced.problem.itemCount << '/' << p.itemCount << " items ("
+                    << stats.unservableOrders << " unservable, " << stats.oversizedOrders << " over ub, "
+                    << stats.duplicateOrders << " duplicate orders, " << stats.dominatedAisles << " dominated aisles)" << std::endl;
+            }
+            if (reduced.problem.orders.empty() || reduced.problem.aisles.empty()) return Solution();
+        } else {
+            reduced.problem = p;
+            reduced.map = Presolve::IdMap::Identity(p);
+        }
+
+        if (config.relabel) {
+            Relabel::Relabeled relabeled = Relabel::apply(reduced.problem);
+            reduced.problem = std::move(relabeled.problem);
+            reduced.map = reduced.map.compose(relabeled.map);
+            if (config.verbose) std::cerr << "Relabeled items, orders and aisles" << std::endl;
+        }
+
+        Config reducedConfig = config;
+        reducedConfig.warmStart = reduced.map.reduce(config.warmStart);
+        return reduced.map.restore(solveReduced(reduced.problem, reducedConfig));
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "common.hpp"
+#include "caches.hpp"
+
+/**
+ * AISLE-COUNT SWEEP
+ * The objective is units / aisles, so for each aisle count k it is enough to
+ * find the wave with the most units using exactly k aisles. A fixed k turns
+ * the ratio into a plain maximization, searched with swaps that keep k
+ * constant. Every k has an upper bound from the k richest aisles, which lets
+ * the driver skip the counts that cannot beat the incumbent.
+ */
+namespace Sweep {
+    struct Bounds {
+        vector<ll> prefix;  // prefix[k] = useful stock of the k richest aisles
+        ll demand = 0;      // units of every order together
+        int kMin = 1;       // fewest aisles whose stock can reach lb
+
+        template<typename L>
+        Bounds(const Problem &p, const Caches<L> &c) {
+            // An aisle is only worth the stock some order asks for
+            vector<ll> itemDemand(p.itemCount, 0);
+            for (size_t o = 0; o < p.orders.size(); o += 1) {
+                for (const auto &line : p.orders[o]) itemDemand[line.ff] += line.ss;
+                demand += c.orderTotalUnits[o];
+            }
+
+            vector<ll> useful(p.aisles.size(), 0);
+            for (size_t a = 0; a < p.aisles.size(); a += 1)
+                for (const auto &line : p.aisles[a]) useful[a] += min<ll>(line.ss, itemDemand[line.ff]);
+            std::sort(useful.rbegin(), useful.rend());
+
+            prefix.assign(p.aisles.size() + 1, 0);
+            for (size_t k = 0; k < useful.size(); k += 1) prefix[k + 1] = prefix[k] + useful[k];
+
+            kMin = 1;
+            while (kMin < (int)p.aisles.size() && prefix[kMin] < p.lb) kMin += 1;
+        }
+
+        int kMax() const { return (int)prefix.size() - 1; }
+
+        // No wave with k aisles can score more than this
+        double at(const Problem &p, int k) const {
+            if (k <= 0 || k > kMax() || prefix[k] < p.lb) return 0.0;
+            return (double)min<ll>({prefix[k], (ll)p.ub, demand}) / k;
+        }
+    };
+
+    // Greedy start: open the aisle with the most to give to unselected orders
+    // and pack what it makes fit, k times. The first pick is randomized.
+    template<typename L>
+    void construction(const Problem &p, const Caches<L> &c, State<L> &state, int k, mt19937 &rng) {
+        for (int step = 0; step < k; step += 1) {
+            int best = -1;
+            ll bestGain = 0;
+            for (int a = 0; a < (int)p.aisles.size(); a += 1) {
+                if (state.aisleSelected[a]) continue;
+                ll gain = state.gainOfAisle(a);
+                if (best == -1 || gain > bestGain) best = a, bestGain = gain;
+            }
+            if (best == -1) break;
+            if (step == 0) {
+                // Any aisle close to the best one
+                vector<int> near = c.similarity.similarAisles(best, 4);
+                near.push_back(best);
+                best = near[uniform_int_distribution<>(0, near.size() - 1)(rng)];
+            }
+            state.addAisle(best);
+            state.packOrdersFromAisle(best);
+        }
+    }
+
+    // Swaps one visited aisle for an unvisited one, keeping k, and keeps the
+    // swap when the wave ends with more units. Stops once ub is reached.
+    template<typename L>
+    void search(const Problem &p, const Caches<L> &c, State<L> &state, mt19937 &rng) {
+        const int MAX_NON_IMPROVING = 100;
+        const int SAMPLE = 16;
+
+        if (state.aisleSolution.empty() || state.aisleSolution.size() == p.aisles.size()) return;
+
+        int nonImproving = 0;
+        while (nonImproving < MAX_NON_IMPROVING && state.currentTotalUnits < p.ub) {
+            nonImproving += 1;
+
+            auto it = state.aisleSolution.begin();
+            std::advance(it, uniform_int_distribution<>(0, state.aisleSolution.size() - 1)(rng));
+            int out = *it;
+
+            int in = -1;
+            ll inGain = 0;
+            vector<int> pool = c.similarity.similarAisles(out, 4);
+            for (int i = 0; i < SAMPLE; i += 1) pool.push_back(uniform_int_distribution<>(0, p.aisles.size() - 1)(rng));
+            for (int a : pool) {
+                if (state.aisleSelected[a]) continue;
+                ll gain = state.gainOfAisle(a);
+                if (in == -1 || gain > inGain) in = a, inGain = gain;
+            }
+            if (in == -1) continue;
+
+            ll before = state.currentTotalUnits;
+            size_t mark = state.checkpoint();
+            state.removeAisle(out);
+            state.dropOrdersToRepairSolution();
+            state.addAisle(in);
+            state.packOrdersFromAisle(in);
+            for (int a : c.similarity.similarAisles(out, 2))
+                if (state.aisleSelected[a]) state.packOrdersFromAisle(a);
+
+            if (state.deficitItems.empty() && state.currentTotalUnits > before) {
+                state.commit(mark);
+                nonImproving = 0;
+            } else {
+                state.rollback(mark);
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+/**
+ * THREAD TEAM
+ * A fixed group of helper threads that splits one loop with the calling
+ * thread. run(n, f) calls f(begin, end, worker) on disjoint slices of
+ * [0, n) and returns once every slice is done: that is the barrier after
+ * which the caller alone may change what the slices were reading. Helpers
+ * sleep on a condition variable between loops.
+ */
+class Team {
+    std::vector<std::thread> helpers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    std::function<void(size_t, size_t, size_t)> job;
+    size_t count = 0, generation = 0, pending = 0;
+    bool stopping = false;
+
+    void slice(size_t worker) {
+        size_t workers = size();
+        job(count * worker / workers, count * (worker + 1) / workers, worker);
+    }
+
+    void serve(size_t worker) {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            slice(worker);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) finished.notify_one();
+        }
+    }
+
+public:
+    // `size` counts the calling thread, so Team(1) runs everything inline
+    explicit Team(size_t size) {
+        for (size_t worker = 1; worker < size; worker += 1)
+            helpers.emplace_back([this, worker] { serve(worker); });
+    }
+
+    ~Team() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &t : helpers) t.join();
+    }
+
+    size_t size() const { return helpers.size() + 1; }
+
+    void run(size_t n, std::function<void(size_t, size_t, size_t)> f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = std::move(f);
+            count = n;
+            pending = helpers.size();
+            generation += 1;
+        }
+        wake.notify_all();
+        slice(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return pending == 0; });
+    }
+};
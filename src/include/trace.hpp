@@ -0,0 +1,142 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+
+/**
+ * EVENT TRACE
+ * Workers push fixed-size events into their own lock-free ring; a background
+ * thread drains all rings and is the only one touching the file.
+ *
+ * Paths ending in ".jsonl" get every event as one JSON object per line.
+ * Any other path keeps the old convergence format ("elapsed score" per new
+ * best), which is what convergence_logs/ and converge.py were built on.
+ */
+namespace Trace {
+    // Skipped: a construction whose aisle set was already refined
+    enum class Phase : uint8_t { Construction, Refinement, Best, Skipped };
+
+    inline const char *phaseName(Phase phase) {
+        switch (phase) {
+            case Phase::Construction: return "construction";
+            case Phase::Refinement: return "refinement";
+            case Phase::Best: return "best";
+            case Phase::Skipped: return "skipped";
+        }
+        return "?";
+    }
+
+    struct Event {
+        double time;      // Seconds since the run started
+        uint32_t thread;
+        int32_t heuristic;
+        Phase phase;
+        double score;
+        ll units;
+        uint32_t aisles;
+    };
+
+    // Single producer (the worker), single consumer (the writer).
+    // A full ring drops the event instead of blocking the worker.
+    struct Ring {
+        static constexpr size_t CAPACITY = 1 << 12;
+
+        std::array<Event, CAPACITY> events;
+        alignas(64) std::atomic<size_t> head{0}; // Next slot to read, owned by the consumer
+        alignas(64) std::atomic<size_t> tail{0}; // Next slot to write, owned by the producer
+        std::atomic<size_t> dropped{0};
+
+        bool push(const Event &event) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) >= CAPACITY) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            events[t % CAPACITY] = event;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        template<typename F>
+        void drain(F &&consume) {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t t = tail.load(std::memory_order_acquire);
+            for (; h < t; h += 1) consume(events[h % CAPACITY]);
+            head.store(h, std::memory_order_release);
+        }
+    };
+
+    class Writer {
+        std::ofstream out;
+        bool jsonl;
+        vector<std::unique_ptr<Ring>> rings;
+        std::atomic<bool> running{true};
+        std::thread drainer;
+        vector<Event> pending;
+
+        void flush() {
+            pending.clear();
+            for (auto &ring : rings) ring->drain([&](const Event &e) { pending.pb(e); });
+            std::sort(all(pending), [](const Event &a, const Event &b) { return a.time < b.time; });
+
+            for (const auto &e : pending) {
+                if (jsonl) {
+                    out << std::fixed << std::setprecision(6)
+                        << "{\"t\": " << e.time << ", \"thread\": " << e.thread
+                        << ", \"heuristic\": " << e.heuristic << ", \"phase\": \"" << phaseName(e.phase)
+                        << "\", \"score\": " << e.score << ", \"units\": " << e.units
+                        << ", \"aisles\": " << e.aisles << "}\n";
+                } else if (e.phase == Phase::Best) {
+                    out << std::fixed << std::setprecision(6) << e.time << " " << e.score << "\n";
+                }
+            }
+            if (!pending.empty()) out.flush();
+        }
+
+    public:
+        Writer(const std::string &path, size_t threadCount)
+            : out(path, std::ios::out | std::ios::trunc),
+              jsonl(path.size() >= 6 && path.compare(path.size() - 6, 6, ".jsonl") == 0)
+        {
+            for (size_t i = 0; i < threadCount; i += 1) rings.pb(std::make_unique<Ring>());
+            drainer = std::thread([this] {
+                while (running.load(std::memory_order_acquire)) {
+                    std::this_thread::sleep_for(chrono::milliseconds(20));
+                    flush();
+                }
+            });
+        }
+
+        ~Writer() {
+            running.store(false, std::memory_order_release);
+            drainer.join();
+            flush();
+
+            size_t dropped = 0;
+            for (auto &ring : rings) dropped += ring->dropped.load();
+            if (dropped > 0) std::cerr << "Trace dropped " << dropped << " events" << std::endl;
+        }
+
+        Ring *ring(size_t thread) { return rings[thread].get(); }
+    };
+
+    // What a worker holds to emit events; a null ring makes every call a no-op
+    struct Probe {
+        Ring *ring = nullptr;
+        uint32_t thread = 0;
+        int32_t heuristic = 0;
+        chrono::high_resolution_clock::time_point start;
+
+        void operator()(Phase phase, ll units, size_t aisles) const {
+            if (ring == nullptr) return;
+            chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+            double score = aisles == 0 ? 0.0 : (double)units / aisles;
+            ring->push({ elapsed.count(), thread, heuristic, phase, score, units, (uint32_t)aisles });
+        }
+    };
+}
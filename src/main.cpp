@@ -1,111 +1,61 @@
 #include "include/common.hpp"
 #include "include/caches.hpp"
-#include "include/heuristic1.cpp"
-#include "include/heuristic2.cpp"
-#include "include/heuristic3.cpp"
-#include "include/heuristic4.cpp"
-
-#include <functional>
-#include <mutex>
-#include <fstream> // Adicionado para manipulação de arquivos
-#include <iomanip> // Adicionado para precisão do tempo
+#include "include/solver.hpp"
+#include "include/counters.hpp"
+#include "include/checker.hpp"
 
 int main(int argc, char *argv[]) {
     srand(time(NULL));
 
-    int chosenHeuristic = -1;
-    // Lendo a heurística (argumento 1)
-    if(1 < argc) chosenHeuristic = std::stoi(argv[1]);
-
-    // Lendo o caminho do log (argumento 2 - opcional)
-    std::string logPath = "";
-    if(2 < argc) logPath = argv[2];
-
-    // Se tiver caminho de log, limpa o arquivo antigo criando um novo vazio
-    if (!logPath.empty()) {
-        std::ofstream ofs(logPath, std::ios::out | std::ios::trunc);
-        ofs.close();
+    Solver::Config config;
+    bool perf = false;
+    std::string warmStartPath, paramsPath;
+    int position = 0;
+    for(int i = 1; i < argc; i += 1) {
+        std::string arg = argv[i];
+        if(arg == "--relabel") config.relabel = true;
+        else if(arg == "--perf") perf = true;
+        else if(arg == "--verify") config.verify = true;
+        else if(arg == "--warm-start" && i + 1 < argc) warmStartPath = argv[++i];
+        else if(arg == "--team" && i + 1 < argc) config.teamSize = std::stoul(argv[++i]);
+        else if(arg == "--threads" && i + 1 < argc) config.threadCount = std::stoul(argv[++i]);
+        else if(arg == "--seed" && i + 1 < argc) Seed::base = std::stoul(argv[++i]);
+        else if(arg == "--params" && i + 1 < argc) paramsPath = argv[++i];
+        else if(arg == "--no-dedup") config.dedupSlots = 0;
+        // Lendo a heurística (argumento 1)
+        else if(position == 0) { config.heuristic = std::stoi(arg); position += 1; }
+        // Lendo o caminho do log (argumento 2 - opcional)
+        else if(position == 1) { config.logPath = arg; position += 1; }
     }
 
     std::cerr << "Reading problem" << std::endl;
     const Problem p = Problem::ReadFrom(cin);
 
-    std::cerr << "Computing caches" << std::endl;
-    const Caches c(p);
+    // The keys of a parameter file override the preset of the size class
+    config.params = Params::preset(p.orders.size(), config.heuristic);
+    if(!paramsPath.empty() && !Params::load(paramsPath, config.params)) return 1;
 
-    std::function<void(Solution&)> heuristic;
-    switch(chosenHeuristic) {
-        case 0:
-            heuristic = [&p](Solution &s) { Heur1::construction(p, s); Heur1::refinement(p, s); };
-            break;
-        default:
-        case 1:
-            heuristic = [&p, &c](Solution &s) { State state(p, c, s); HeurCached::construction(p, c, state); HeurCached::refinement(p, c, state); };
-            break;
-        case 2:
-            heuristic = [&p, &c](Solution &s) { State state(p, c, s); Heur3::construction(p, c, state); HeurCached::refinement(p, c, state); };
-            break;
-        case 3:
-            heuristic = [&p, &c](Solution &s) { State state(p, c, s); Heur4::construction(p, c, state); HeurCached::refinement(p, c, state); };
-            break;
+    // Ids the instance does not have are left out; the rest may still be
+    // infeasible (a changed snapshot) and is then only a starting point
+    if(!warmStartPath.empty()) {
+        Checker::RawSolution raw;
+        if(!Checker::readSolutionFile(warmStartPath, raw)) {
+            std::cerr << "Cannot read warm start " << warmStartPath << std::endl;
+            return 1;
+        }
+        Checker::Report report = Checker::check(p, raw);
+        std::cerr << "Loaded warm start: " << report.objective << ", "
+            << report.violations.size() << " violations" << std::endl;
+        for(ll o: raw.orders)
+            if(0 <= o && o < (ll)p.orders.size()) config.warmStart.mOrders.insert(o);
+        for(ll a: raw.aisles)
+            if(0 <= a && a < (ll)p.aisles.size()) config.warmStart.mAisles.insert(a);
     }
 
-    size_t threadCount = std::thread::hardware_concurrency();
-    
-    // Marca o tempo de início total
-    auto startTime = chrono::high_resolution_clock::now(); 
-    auto lastImprovement = startTime;
-    auto patience = chrono::seconds(3);
-
-    std::cerr << "Running threads" << std::endl;
-    std::vector<std::thread> threads;
-    
-    mutex solutionMutex;
-    Solution bestSolution;
-    double bestScore = 0.0;
-
-    threads.reserve(threadCount);
-    for(size_t threadIndex = 0; threadIndex < threadCount; threadIndex += 1) {
-        threads.emplace_back([&] {
-            auto now = chrono::high_resolution_clock::now();
-            while (now < lastImprovement + patience) {
-                Solution solution; 
-                heuristic(solution);
-                double score = solution.calculateScore(p);
-                bool feasible = solution.checkFeasibility(p);
-
-                if(!feasible) {
-                    continue;
-                }
-                
-                solutionMutex.lock();
-                now = chrono::high_resolution_clock::now();
-                if (score > bestScore) {
-                    std::cerr << "New best! " << score << ' ' << (feasible ? "Feasible" : "Unfeasible") << std::endl;
-                    
-                    bestScore = score;
-                    bestSolution = solution;
-                    lastImprovement = now;
-
-                    // --- TRECHO ADICIONADO: LOG PARA GRÁFICO ---
-                    if (!logPath.empty()) {
-                        // Calcula tempo decorrido desde o início em segundos
-                        chrono::duration<double> elapsed = now - startTime;
-                        
-                        // Abre em modo append (adicionar ao final)
-                        std::ofstream logFile(logPath, std::ios::app);
-                        if (logFile.is_open()) {
-                            logFile << std::fixed << std::setprecision(6) << elapsed.count() << " " << score << "\n";
-                            logFile.close();
-                        }
-                    }
-                    // ------------------------------------------
-                }
-                solutionMutex.unlock();
-            }
-        });
-    }
-    for(auto &t: threads) t.join();
+    Perf::Session session;
+    if(perf) session.begin();
+    Solution bestSolution = Solver::solve(p, config);
+    if(perf) Perf::report(std::cerr, session.end());
 
     std::cerr << "Final best " << bestSolution.calculateScore(p) << ' '
         << (bestSolution.checkFeasibility(p) ? "Feasible" : "Unfeasible") << ", "
@@ -114,6 +64,6 @@ int main(int argc, char *argv[]) {
         << bestSolution.getTotalUnits(p) << " units" << std::endl;
 
     bestSolution.print();
-    
+
     exit(0);
-}
\ No newline at end of file
+}
@@ -99,7 +99,7 @@ def run_set(set_name):
         output_file = os.path.join(output_folder, f"{instance_name}.txt")
         
         # Caminho do arquivo de log para esta instância
-        log_file = os.path.join(log_folder, f"{instance_name}.log")
+        log_file = os.path.join(log_folder, f"{instance_name}.jsonl")
 
         print(f"  Rodando: {filename}")
         wop = WaveOrderPicking()
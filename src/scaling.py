@@ -0,0 +1,144 @@
+import os
+import sys
+import csv
+import json
+import time
+import signal
+import subprocess
+import threading
+
+try:
+    import matplotlib.pyplot as plt
+except ImportError:
+    plt = None
+
+# Gera instâncias sintéticas cada vez maiores (bin/generator) e mede, para
+# cada uma, o tempo até a primeira solução, o tempo total e o pico de memória
+# do solver. Uso: python3 scaling.py [heurística] [timeout_s] [ordens ...]
+
+ROOT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+SRC_DIR = os.path.abspath(os.path.dirname(__file__))
+SOLVER = os.path.join(SRC_DIR, "bin", "solver")
+GENERATOR = os.path.join(SRC_DIR, "bin", "generator")
+SCALING_DIR = os.path.join(ROOT_DIR, "scaling")
+PLOT_PATH = os.path.join(ROOT_DIR, "plots", "scaling.png")
+
+DEFAULT_SIZES = [10_000, 30_000, 100_000, 300_000, 1_000_000]
+
+def shape_for(orders):
+    """Itens e corredores crescem com as ordens, na proporção dos maiores datasets (b/0011)."""
+    items = max(100, int(orders * 0.8))
+    aisles = max(50, min(5000, int(orders ** 0.5 * 2.3)))
+    return items, aisles
+
+def generate(orders, seed=1):
+    path = os.path.join(SCALING_DIR, f"synthetic_{orders}.txt")
+    if os.path.exists(path):
+        return path
+    items, aisles = shape_for(orders)
+    with open(path, "w") as out:
+        subprocess.run([GENERATOR, "-o", str(orders), "-i", str(items), "-a", str(aisles), "-s", str(seed)],
+                       stdout=out, check=True)
+    return path
+
+def first_solution_time(log_path):
+    """Instante (s) do primeiro evento de construção no trace, ou None."""
+    if not os.path.exists(log_path):
+        return None
+    with open(log_path) as f:
+        for line in f:
+            if line.strip():
+                event = json.loads(line)
+                if event.get("phase") == "construction":
+                    return float(event["t"])
+    return None
+
+def measure(instance, heuristic, timeout):
+    """Roda o solver uma vez; o pico de memória vem do rusage do próprio filho."""
+    log_path = instance.replace(".txt", ".jsonl")
+    if os.path.exists(log_path):
+        os.remove(log_path)
+    start = time.time()
+    with open(instance) as f_in:
+        proc = subprocess.Popen([SOLVER, str(heuristic), log_path], stdin=f_in,
+                                stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    timer = threading.Timer(timeout, lambda: proc.send_signal(signal.SIGKILL))
+    timer.start()
+    stderr = proc.stderr.read()
+    _, status, usage = os.wait4(proc.pid, 0)
+    timer.cancel()
+    seconds = time.time() - start
+
+    score = None
+    for line in stderr.splitlines():
+        if line.startswith("Final best"):
+            score = float(line.split()[2])
+    return {
+        "seconds": seconds,
+        "timed_out": os.WIFSIGNALED(status),
+        "first_solution": first_solution_time(log_path),
+        "peak_mib": usage.ru_maxrss / 1024.0,
+        "score": score,
+    }
+
+def plot(rows):
+    if plt is None:
+        print("matplotlib não encontrado, gráfico não gerado")
+        return
+    orders = [r["orders"] for r in rows]
+    fig, (ax_time, ax_mem) = plt.subplots(1, 2, figsize=(12, 5))
+
+    ax_time.plot(orders, [r["seconds"] for r in rows], "o-", label="total")
+    ax_time.plot(orders, [r["first_solution"] or float("nan") for r in rows], "s--", label="primeira solução")
+    ax_time.set_xscale("log")
+    ax_time.set_yscale("log")
+    ax_time.set_xlabel("Ordens")
+    ax_time.set_ylabel("Tempo (s)")
+    ax_time.legend()
+    ax_time.grid(True, which="both", alpha=0.3)
+
+    ax_mem.plot(orders, [r["peak_mib"] for r in rows], "o-", color="tab:red")
+    ax_mem.set_xscale("log")
+    ax_mem.set_yscale("log")
+    ax_mem.set_xlabel("Ordens")
+    ax_mem.set_ylabel("Pico de memória (MiB)")
+    ax_mem.grid(True, which="both", alpha=0.3)
+
+    fig.suptitle("Escalabilidade em instâncias sintéticas")
+    fig.tight_layout()
+    os.makedirs(os.path.dirname(PLOT_PATH), exist_ok=True)
+    fig.savefig(PLOT_PATH)
+    print(f"Gráfico salvo em {PLOT_PATH}")
+
+def main():
+    heuristic = int(sys.argv[1]) if len(sys.argv) > 1 else 1
+    timeout = float(sys.argv[2]) if len(sys.argv) > 2 else 600.0
+    sizes = [int(x) for x in sys.argv[3:]] or DEFAULT_SIZES
+
+    for binary in (SOLVER, GENERATOR):
+        if not os.path.exists(binary):
+            print(f"Binário não encontrado: {binary} (rode make)")
+            sys.exit(1)
+    os.makedirs(SCALING_DIR, exist_ok=True)
+
+    rows = []
+    for orders in sizes:
+        instance = generate(orders)
+        result = measure(instance, heuristic, timeout)
+        row = {"orders": orders, **result}
+        rows.append(row)
+        first = row["first_solution"]
+        print(f"{orders:>9} ordens: {row['seconds']:8.1f}s"
+              f"{' (timeout)' if row['timed_out'] else ''}, primeira solução "
+              f"{'-' if first is None else f'{first:.1f}s'}, {row['peak_mib']:.0f} MiB, score {row['score']}")
+
+    csv_path = os.path.join(SCALING_DIR, "scaling.csv")
+    with open(csv_path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"Resultados salvos em {csv_path}")
+    plot(rows)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+import json
+import os
+import sys
+from collections import defaultdict
+
+# Resumo compacto de um trace .jsonl gerado pelo solver:
+# eventos por fase, iterações por thread, primeira/última melhoria e melhor score.
+#
+# Uso: python trace_summary.py <trace.jsonl> [<trace.jsonl> ...]
+
+def summarize(path):
+    phases = defaultdict(int)
+    per_thread = defaultdict(int)
+    best = None
+    first_best_t = None
+    last_best_t = None
+    last_t = 0.0
+    heuristics = set()
+
+    with open(path, 'r') as f:
+        for line in f:
+            if not line.strip():
+                continue
+            e = json.loads(line)
+            phases[e["phase"]] += 1
+            heuristics.add(e["heuristic"])
+            last_t = max(last_t, e["t"])
+            if e["phase"] == "refinement":
+                per_thread[e["thread"]] += 1
+            elif e["phase"] == "best":
+                if first_best_t is None:
+                    first_best_t = e["t"]
+                last_best_t = e["t"]
+                best = e
+
+    name = os.path.basename(path)
+    if best is None:
+        print(f"{name}: sem melhorias registradas")
+        return
+
+    # Instâncias resolvidas pela busca exata só têm o evento "best"
+    iterations = sum(per_thread.values())
+    rate = iterations / last_t if iterations > 0 and last_t > 0 else 0.0
+    print(f"{name}: best {best['score']:.4f} ({best['units']} unidades / {best['aisles']} corredores)"
+          f" heur {sorted(heuristics)}")
+    print(f"  primeira melhoria {first_best_t:.3f}s, última {last_best_t:.3f}s, fim {last_t:.3f}s")
+    print(f"  eventos: " + ", ".join(f"{k}={v}" for k, v in sorted(phases.items())))
+    if per_thread:
+        print(f"  iterações: {iterations} ({rate:.1f}/s) em {len(per_thread)} threads, "
+              f"min {min(per_thread.values())} max {max(per_thread.values())} por thread")
+    else:
+        print(f"  iterações: 0 (sem refinamento no trace)")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Uso: python trace_summary.py <trace.jsonl> [...]")
+        sys.exit(1)
+    for path in sys.argv[1:]:
+        summarize(path)
@@ -0,0 +1,213 @@
+import os
+import sys
+import math
+import time
+import random
+import argparse
+
+from benchmark import DATASETS_DIR, BEST_PATH, SOLVER, read_best_objectives, run_once, time_to
+
+# Tuner por corrida (no espírito do F-race/irace) das constantes de
+# include/params.hpp. Para cada classe de tamanho sorteia configurações,
+# roda todas as sobreviventes instância a instância (com sementes fixas) e,
+# a partir do terceiro passo, elimina as que ficam estatisticamente atrás
+# no rank médio (teste de Friedman + diferença crítica). O custo de uma
+# rodada é o tempo até o alvo (fração do best_objective); quem não chega
+# paga PAR10 (dez vezes o corte) vezes (1 + gap final): a penalidade não
+# depende de quanto a rodada durou. A paciência não entra na corrida: o
+# tempo até o alvo não enxerga o que uma paciência curta deixa de achar.
+#
+# Uso: python3 tune.py [-m heurística] [-b orçamento_s por classe] [-n candidatas] [--target 0.9]
+# As vencedoras vão para tuning/<classe>.params e o trecho para
+# Params::preset é impresso no final; o preset vale só para a heurística
+# que foi corrida (hoje, a 1).
+
+ROOT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+TUNING_DIR = os.path.join(ROOT_DIR, "tuning")
+
+# Mesmas fronteiras de Params::preset
+CLASSES = [("small", 0, 1000), ("medium", 1001, 10000), ("large", 10001, float("inf"))]
+
+# Espaço de busca: (tipo, mínimo, máximo) com os nomes das chaves do arquivo
+SPACE = {
+    "alpha_greedy": (float, 0.05, 0.8),
+    "alpha_cached": (float, 0.05, 0.9),
+    "rcl_size": (int, 2, 48),
+    "alpha_sampled": (float, 0.05, 0.9),
+    "sample_min": (int, 4, 32),
+    "sample_max": (int, 32, 160),
+    "spread_full": (float, 0.1, 2.0),
+    "aisle_candidates": (int, 4, 48),
+    "similar_aisles": (int, 0, 16),
+    "perturb_share": (float, 0.05, 0.5),
+}
+DEFAULTS = {"alpha_greedy": 0.3, "alpha_cached": 0.5, "rcl_size": 16, "alpha_sampled": 0.5, "sample_min": 16,
+            "sample_max": 80, "spread_full": 0.5, "aisle_candidates": 16, "similar_aisles": 8,
+            "perturb_share": 0.2, "patience": 3.0}
+
+# Só as chaves que a heurística lê são sorteadas; as outras ficam no padrão
+REFINEMENT_KEYS = ["aisle_candidates", "similar_aisles"]
+MODE_KEYS = {
+    "0": ["alpha_greedy"],
+    "1": ["alpha_cached", "rcl_size"] + REFINEMENT_KEYS,
+    "2": ["alpha_sampled", "sample_min", "sample_max", "spread_full"] + REFINEMENT_KEYS,
+    "3": ["alpha_sampled", "sample_min", "sample_max", "spread_full"] + REFINEMENT_KEYS,
+}
+
+PAR = 10
+
+def sample_config(rng, keys):
+    config = dict(DEFAULTS)
+    for key in keys:
+        kind, low, high = SPACE[key]
+        config[key] = rng.randint(low, high) if kind is int else round(rng.uniform(low, high), 3)
+    return config
+
+def write_config(config, path):
+    with open(path, "w") as f:
+        for key, value in config.items():
+            f.write(f"{key} = {value}\n")
+
+def instances_by_class(best):
+    """Instâncias com best_objective, separadas pela contagem de ordens (1ª linha)."""
+    classes = {name: [] for name, _, _ in CLASSES}
+    for dataset, name in sorted(best):
+        path = os.path.join(DATASETS_DIR, dataset, name)
+        if not os.path.exists(path):
+            continue
+        with open(path) as f:
+            orders = int(f.readline().split()[0])
+        for cls, low, high in CLASSES:
+            if low <= orders <= high:
+                classes[cls].append(f"{dataset}/{name}")
+    return classes
+
+def cost_of(instance, mode, params_path, seed, reference, args, log_path):
+    final, seconds, events = run_once(instance, f"{mode} --params {params_path}", seed, 1, log_path)
+    ttt = time_to(events, args.target * reference)
+    if ttt is not None and ttt <= args.cutoff:
+        return ttt
+    gap = max(0.0, (reference - final) / reference) if reference > 0 else 0.0
+    return PAR * args.cutoff * (1 + gap)
+
+def ranks(costs):
+    """Ranks 1..k (empates com a média) de uma lista de custos."""
+    order = sorted(range(len(costs)), key=lambda i: costs[i])
+    result = [0.0] * len(costs)
+    i = 0
+    while i < len(order):
+        j = i
+        while j + 1 < len(order) and costs[order[j + 1]] == costs[order[i]]:
+            j += 1
+        for t in range(i, j + 1):
+            result[order[t]] = (i + j) / 2 + 1
+        i = j + 1
+    return result
+
+def mean_ranks(cost_rows, alive):
+    """Rank médio de cada viva, ranqueando só entre as vivas em cada passo."""
+    total = {c: 0.0 for c in alive}
+    for row in cost_rows:
+        for c, r in zip(alive, ranks([row[c] for c in alive])):
+            total[c] += r
+    return {c: total[c] / max(1, len(cost_rows)) for c in alive}
+
+def chi2_critical(df, z=1.645):
+    """Quantil 95% da qui-quadrado pela aproximação de Wilson-Hilferty."""
+    return df * (1 - 2 / (9 * df) + z * math.sqrt(2 / (9 * df))) ** 3
+
+def race(cls, instances, best, args, rng):
+    keys = MODE_KEYS.get(args.mode.split()[0], list(SPACE))
+    candidates = [dict(DEFAULTS)] + [sample_config(rng, keys) for _ in range(args.candidates - 1)]
+    paths = []
+    for i, config in enumerate(candidates):
+        path = os.path.join(TUNING_DIR, f"{cls}_candidate_{i}.params")
+        write_config(config, path)
+        paths.append(path)
+
+    alive = list(range(len(candidates)))
+    cost_rows = []  # por passo, candidata -> custo; as vivas correram todos
+    start = time.time()
+    step = 0
+    while len(alive) > 1 and time.time() - start < args.budget:
+        instance = instances[step % len(instances)]
+        seed = args.seed + step // len(instances)
+        dataset, name = instance.split("/")
+        reference = best[(dataset, name)]
+        log_path = os.path.join(TUNING_DIR, "race.jsonl")
+        costs = [cost_of(instance, args.mode, paths[c], seed, reference, args, log_path) for c in alive]
+        cost_rows.append(dict(zip(alive, costs)))
+        step += 1
+
+        n, k = len(cost_rows), len(alive)
+        mean = mean_ranks(cost_rows, alive)
+        print(f"[{cls}] passo {step} ({instance}, semente {seed}): {k} vivas, melhor "
+              f"{min(alive, key=lambda c: mean[c])} (rank médio {min(mean.values()):.2f})")
+        if n < args.first_test or k < 2:
+            continue
+
+        # Friedman sobre os ranks médios; se há diferença, cai quem está a
+        # mais de uma diferença crítica da melhor
+        friedman = 12 * n / (k * (k + 1)) * sum((mean[c] - (k + 1) / 2) ** 2 for c in alive)
+        if friedman <= chi2_critical(k - 1):
+            continue
+        critical = 1.96 * math.sqrt(k * (k + 1) / (6 * n))
+        leader = min(mean.values())
+        dropped = [c for c in alive if mean[c] - leader > critical]
+        alive = [c for c in alive if c not in dropped]
+        if dropped:
+            print(f"[{cls}] eliminadas: {dropped}")
+
+    mean = mean_ranks(cost_rows, alive)
+    winner = min(alive, key=lambda c: mean[c])
+    return candidates[winner], winner
+
+def preset_summary(winners):
+    """O que mudou em relação ao padrão, classe a classe, para Params::preset."""
+    lines = []
+    for cls, _, high in CLASSES:
+        if cls not in winners:
+            continue
+        lines.append(f"# {cls} (até {high} ordens)")
+        lines += [f"{k} = {v}" for k, v in winners[cls].items() if DEFAULTS[k] != v]
+    return "\n".join(lines)
+
+def main():
+    parser = argparse.ArgumentParser(description="Corrida de configurações para Params::preset")
+    parser.add_argument("-m", "--mode", default="1", help="heurística e flags do solver")
+    parser.add_argument("-b", "--budget", type=float, default=1800.0, help="segundos por classe")
+    parser.add_argument("-n", "--candidates", type=int, default=12)
+    parser.add_argument("-s", "--seed", type=int, default=1)
+    parser.add_argument("--target", type=float, default=0.9, help="fração do best_objective")
+    parser.add_argument("--cutoff", type=float, default=10.0, help="segundos; alvo depois disso não conta")
+    parser.add_argument("--first-test", type=int, default=3, help="passos antes do primeiro teste")
+    parser.add_argument("--max-instances", type=int, default=8, help="instâncias por classe")
+    parser.add_argument("-c", "--classes", nargs="*", default=[c for c, _, _ in CLASSES])
+    args = parser.parse_args()
+
+    if not os.path.exists(SOLVER):
+        print(f"Binário não encontrado: {SOLVER} (rode make)")
+        sys.exit(1)
+    os.makedirs(TUNING_DIR, exist_ok=True)
+
+    rng = random.Random(args.seed)
+    best = read_best_objectives(BEST_PATH)
+    classes = instances_by_class(best)
+    winners = {}
+    for cls in args.classes:
+        instances = classes.get(cls, [])
+        rng.shuffle(instances)
+        instances = instances[:args.max_instances]
+        if not instances:
+            print(f"[{cls}] sem instâncias")
+            continue
+        config, index = race(cls, instances, best, args, rng)
+        winners[cls] = config
+        path = os.path.join(TUNING_DIR, f"{cls}.params")
+        write_config(config, path)
+        print(f"[{cls}] vencedora: candidata {index}, salva em {path}")
+
+    print(preset_summary(winners))
+
+if __name__ == "__main__":
+    main()